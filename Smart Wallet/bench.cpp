@@ -0,0 +1,497 @@
+// Benchmark harness for the Smart Wallet. It links the wallet core and the
+// console screens, so every scenario runs the same code the interactive
+// program does.
+//
+// Build:  cmake --build <build dir> --target wallet_bench
+//
+// Usage:
+//   wallet_bench generate <bank_data.txt> <users> <history per user> <scheduled payments> [seed]
+//   wallet_bench [--durability <mode>] run <bank_data.txt> <work dir> [operations]
+//   wallet_bench load_destroy <bank_data.txt> <work dir> [runs]
+//   wallet_bench lookup <accounts> [lookups]
+//   wallet_bench reconcile <millions of transactions> [accounts]
+//
+// generate writes a text data file with the given number of users, each
+// with that many past transactions spread over the last year, and that
+// many scheduled payments, half of them already due.
+//
+// run copies the data file into the work directory (removing any snapshot
+// or journal left there), then times, in order: loading the text file,
+// saving a full checkpoint, loading that checkpoint, account lookups,
+// transfers, undoing deposits and transfers, history display and
+// processing the due scheduled payments. Each result is one JSON object per line on stdout, e.g.
+//   {"scenario":"transfer","ops":100000,"seconds":1.93,"ops_per_sec":51813,"ns_per_op":19300}
+// so runs can be diffed release over release.
+//
+// load_destroy prepares the work directory the same way, loads the text
+// file and saves it as a snapshot, then times loading that snapshot and
+// destroying the bank, runs times over. Teardown of long histories is
+// what it is for, e.g. on 10M transactions:
+//   wallet_bench generate big.txt 1000 10000 0
+//   wallet_bench load_destroy big.txt /tmp/work
+//
+// lookup builds an in-memory bank of that many accounts and times random
+// lookups through the indexes by account number, user ID and email, next
+// to the linear scan they replaced (run fewer times on large banks).
+//
+// reconcile spreads that many random deposits and withdrawals (in integer
+// cents) over the accounts, then replays every history and checks each
+// running total against the balance recorded on that row and the account
+// balance at the end. The same replay in double is timed next to it and
+// counts the rows where it has stopped being exact.
+#include "console.h"
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Discards everything written to it, but only after the stream has done
+// the formatting, so display scenarios still pay for building the text.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) {
+        return c;
+    }
+    streamsize xsputn(const char*, streamsize n) {
+        return n;
+    }
+};
+
+class BenchRandom {
+public:
+    unsigned long long state;
+
+    explicit BenchRandom(unsigned long long seed) : state(seed * 2654435761ULL + 1) {}
+
+    unsigned long long next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    int below(int n) {
+        return static_cast<int>(next() % static_cast<unsigned long long>(n));
+    }
+};
+
+string benchAccountNumber(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "ACC%010d", i);
+    return buf;
+}
+
+int generateBankData(const string& fileName, int users, int history, int payments, unsigned long long seed) {
+    if (users < 2 || history < 0 || payments < 0) {
+        cout << "Usage: generate <bank_data.txt> <users >= 2> <history per user> <scheduled payments> [seed]" << endl;
+        return 1;
+    }
+    BenchRandom random(seed);
+    BankingSystem bank(false);
+    long now = static_cast<long>(time(nullptr));
+    const long YEAR = 365L * 24 * 60 * 60;
+    for (int i = 0; i < users; i++) {
+        User* user = new User("Bench User", "USER" + to_string(1000 + i), "password", "1234",
+                              "user" + to_string(i) + "@example.com", "03001234567", "Street " + to_string(i), "Savings", Money());
+        user->accountNumber = benchAccountNumber(i);
+        user->dateCreated = "2024-01-01";
+        Money balance(10000000);
+        long timestamp = now - YEAR;
+        user->transactions.reserve(history + 1);
+        user->transactions.addTransaction(IDGenerator::instance().next(), TXN_ACCOUNT_CREATION, balance, balance, "", timestamp);
+        for (int k = 0; k < history; k++) {
+            timestamp += 1 + static_cast<long>(random.next() % static_cast<unsigned long long>(2 * YEAR / (history + 1)));
+            if (timestamp > now) timestamp = now;
+            Money amount(static_cast<long long>(random.next() % 500000) + 100);
+            unsigned short type = TXN_DEPOSIT;
+            string other;
+            int kind = random.below(4);
+            if (kind == 1 && amount <= balance) {
+                type = TXN_WITHDRAW;
+            } else if (kind >= 2 && amount <= balance) {
+                type = kind == 2 ? TXN_TRANSFER_OUT : TXN_TRANSFER_IN;
+                other = benchAccountNumber(random.below(users));
+            }
+            if (type == TXN_WITHDRAW || type == TXN_TRANSFER_OUT) balance -= amount;
+            else balance += amount;
+            user->transactions.addTransaction(IDGenerator::instance().next(), type, amount, balance, other, timestamp);
+        }
+        user->balance = balance;
+        if (bank.userCount >= bank.capacity) {
+            bank.resizeArray();
+        }
+        bank.users[bank.userCount] = user;
+        bank.indexUser(bank.userCount);
+        bank.userCount++;
+    }
+    bank.nextUserID = 1000 + users;
+    for (int i = 0; i < payments; i++) {
+        int from = random.below(users);
+        int to = (from + 1 + random.below(users - 1)) % users;
+        long executeAt = i % 2 == 0 ? now - 1 - random.below(3600) : now + 60 + random.below(30 * 24 * 60 * 60);
+        string id = "PAY" + to_string(IDGenerator::instance().next());
+        bank.scheduledPayments.enqueue(id, executeAt, bank.users[from]->accountNumber, bank.users[to]->accountNumber,
+                                       Money(static_cast<long long>(random.next() % 10000) + 100));
+    }
+    if (!bank.saveTextFile(fileName, 0)) {
+        cout << "Could not write " << fileName << endl;
+        return 1;
+    }
+    cout << "Generated " << users << " user(s) with " << history << " transaction(s) each and " << payments
+         << " scheduled payment(s) in " << fileName << endl;
+    return 0;
+}
+
+class BenchReport {
+public:
+    chrono::steady_clock::time_point started;
+
+    void start() {
+        started = chrono::steady_clock::now();
+    }
+
+    void finish(const string& scenario, long long ops) {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        double perOp = ops > 0 ? seconds * 1e9 / static_cast<double>(ops) : 0;
+        double perSecond = seconds > 0 ? static_cast<double>(ops) / seconds : 0;
+        printf("{\"scenario\":\"%s\",\"ops\":%lld,\"seconds\":%.6f,\"ops_per_sec\":%.0f,\"ns_per_op\":%.0f}\n",
+               scenario.c_str(), ops, seconds, perSecond, perOp);
+        fflush(stdout);
+    }
+};
+
+bool copyFile(const string& from, const string& to) {
+    ifstream in(from.c_str(), ios::binary);
+    ofstream out(to.c_str(), ios::binary | ios::trunc);
+    if (!in.is_open() || !out.is_open()) return false;
+    out << in.rdbuf();
+    return !out.fail();
+}
+
+// Copies the data file into the work directory as bank_data.txt, makes
+// that the working directory and removes any snapshot or journal left
+// there, so the first load reads the text file.
+bool enterWorkDirectory(const string& dataFile, const string& workDirectory) {
+    ::mkdir(workDirectory.c_str(), 0700);
+    string work = workDirectory + "/";
+    if (!copyFile(dataFile, work + "bank_data.txt")) {
+        cout << "Could not copy " << dataFile << " to " << work << endl;
+        return false;
+    }
+    if (::chdir(workDirectory.c_str()) != 0) return false;
+    DIR* listing = ::opendir(".");
+    while (dirent* entry = listing == nullptr ? nullptr : ::readdir(listing)) {
+        string name = entry->d_name;
+        if (name.compare(0, 13, "bank_data.bin") == 0 || name.compare(0, 17, "bank_data.journal") == 0) ::unlink(name.c_str());
+    }
+    if (listing != nullptr) ::closedir(listing);
+    return true;
+}
+
+int runBenchmarks(const string& dataFile, const string& workDirectory, long long operations) {
+    if (operations < 1) {
+        cout << "Usage: run <bank_data.txt> <work dir> [operations]" << endl;
+        return 1;
+    }
+    if (!enterWorkDirectory(dataFile, workDirectory)) return 1;
+
+    NullBuffer sink;
+    BenchReport report;
+    BenchRandom random(42);
+
+    {
+        report.start();
+        BankingSystem bank;
+        report.finish("load_text", bank.userCount);
+        long long records = 0;
+        for (int i = 0; i < bank.userCount; i++) {
+            records += bank.users[i]->getTransactionCount();
+        }
+        const char* durability[] = {"sync", "group", "async"};
+        printf("{\"bench\":\"smart-wallet\",\"users\":%d,\"transactions\":%lld,\"scheduled_payments\":%d,\"durability\":\"%s\"}\n",
+               bank.userCount, records, bank.scheduledPayments.size(), durability[DurabilityConfig::current().mode]);
+        report.start();
+        bank.saveToFile();
+        report.finish("save", bank.userCount);
+    }
+    report.start();
+    BankingSystem bank;
+    report.finish("load_snapshot", bank.userCount);
+    // Screens, prompts and messages are built as usual and handed to the
+    // sink instead of stdout.
+    ostream screenSink(&sink);
+    WalletConsole screens(bank, screenSink);
+    int users = bank.userCount;
+    if (users < 2) {
+        cout << "The data file needs at least two users." << endl;
+        return 1;
+    }
+
+    report.start();
+    long long found = 0;
+    for (long long i = 0; i < operations; i++) {
+        int index = random.below(users);
+        if (bank.findUserByAccountNumber(bank.users[index]->accountNumber) == index) found++;
+        if (bank.findUserByUserID(bank.users[random.below(users)]->userID) >= 0) found++;
+    }
+    report.finish("lookup", found);
+
+    report.start();
+    for (long long i = 0; i < operations; i++) {
+        int from = random.below(users);
+        int to = (from + 1 + random.below(users - 1)) % users;
+        bank.applyTransfer(bank.users[from], bank.users[to], Money(100));
+        bank.commit();
+    }
+    report.finish("transfer", operations);
+
+    report.start();
+    for (long long i = 0; i < operations; i++) {
+        User* user = bank.users[random.below(users)];
+        bank.applyDeposit(user, Money(500));
+        bank.undoLast(user);
+        bank.commit();
+    }
+    report.finish("deposit_undo", operations);
+
+    report.start();
+    for (long long i = 0; i < operations; i++) {
+        int from = random.below(users);
+        int to = (from + 1 + random.below(users - 1)) % users;
+        bank.applyTransfer(bank.users[from], bank.users[to], Money(100));
+        bank.undoLast(bank.users[from]);
+        bank.commit();
+    }
+    report.finish("transfer_undo", operations);
+
+    report.start();
+    int rows[BankingSystem::HISTORY_PAGE_SIZE];
+    for (long long i = 0; i < operations; i++) {
+        User* user = bank.users[random.below(users)];
+        int n = user->transactions.queryLast(BankingSystem::HISTORY_PAGE_SIZE, rows);
+        screens.displayTransactionRows(user, rows, n);
+    }
+    report.finish("history_page", operations);
+
+    long long historyRuns = operations / 100 > 0 ? operations / 100 : 1;
+    report.start();
+    for (long long i = 0; i < historyRuns; i++) {
+        screens.displayTransactionHistory(bank.users[random.below(users)]);
+    }
+    report.finish("history_full", historyRuns);
+
+    report.start();
+    int processed = bank.processScheduledPayments();
+    report.finish("scheduled", processed);
+
+    return 0;
+}
+
+int runLoadDestroyBenchmark(const string& dataFile, const string& workDirectory, int runs) {
+    if (runs < 1) {
+        cout << "Usage: load_destroy <bank_data.txt> <work dir> [runs]" << endl;
+        return 1;
+    }
+    if (!enterWorkDirectory(dataFile, workDirectory)) return 1;
+    BenchReport report;
+    long long records = 0;
+    bool saved;
+    {
+        report.start();
+        BankingSystem bank;
+        for (int i = 0; i < bank.userCount; i++) {
+            records += bank.users[i]->getTransactionCount();
+        }
+        report.finish("load_text", records);
+        printf("{\"bench\":\"smart-wallet-load-destroy\",\"users\":%d,\"transactions\":%lld}\n", bank.userCount, records);
+        report.start();
+        saved = bank.saveToFile();
+        report.finish("save", records);
+    }
+    if (!saved) {
+        cout << "Could not save a snapshot in " << workDirectory << endl;
+        return 1;
+    }
+    // Every later load reads the snapshot just written and finds its
+    // journal clean, so destroy is teardown alone, with no save in it.
+    for (int run = 0; run < runs; run++) {
+        {
+            report.start();
+            BankingSystem bank;
+            report.finish("load_snapshot", records);
+            report.start();
+        }
+        report.finish("destroy", records);
+    }
+    return 0;
+}
+
+int runLookupBenchmark(int accounts, long long lookups) {
+    if (accounts < 1 || lookups < 1) {
+        cout << "Usage: lookup <accounts> [lookups]" << endl;
+        return 1;
+    }
+    BankingSystem bank(false);
+    for (int i = 0; i < accounts; i++) {
+        User* user = new User("Bench User", "USER" + to_string(1000 + i), "password", "1234",
+                              "user" + to_string(i) + "@example.com", "03001234567", "Street " + to_string(i), "Savings", Money());
+        user->accountNumber = benchAccountNumber(i);
+        if (bank.userCount >= bank.capacity) {
+            bank.resizeArray();
+        }
+        bank.users[bank.userCount] = user;
+        bank.indexUser(bank.userCount);
+        bank.userCount++;
+    }
+    printf("{\"bench\":\"smart-wallet-lookup\",\"users\":%d}\n", accounts);
+    BenchReport report;
+    BenchRandom random(42);
+    long long found = 0;
+
+    report.start();
+    for (long long i = 0; i < lookups; i++) {
+        int index = random.below(accounts);
+        if (bank.findUserByAccountNumber(bank.users[index]->accountNumber) == index) found++;
+    }
+    report.finish("lookup_account", lookups);
+
+    report.start();
+    for (long long i = 0; i < lookups; i++) {
+        int index = random.below(accounts);
+        if (bank.findUserByUserID(bank.users[index]->userID) == index) found++;
+    }
+    report.finish("lookup_user_id", lookups);
+
+    report.start();
+    for (long long i = 0; i < lookups; i++) {
+        if (!bank.isEmailUnique(bank.users[random.below(accounts)]->email)) found++;
+    }
+    report.finish("lookup_email", lookups);
+
+    // The scan compares about accounts / 2 keys per lookup, so it is capped
+    // at roughly 10^8 comparisons in all.
+    long long scans = 100000000LL / accounts;
+    if (scans > lookups) scans = lookups;
+    if (scans < 1) scans = 1;
+    report.start();
+    for (long long i = 0; i < scans; i++) {
+        const string& key = bank.users[random.below(accounts)]->accountNumber;
+        for (int k = 0; k < bank.userCount; k++) {
+            if (bank.users[k]->accountNumber == key) {
+                found++;
+                break;
+            }
+        }
+    }
+    report.finish("scan_account", scans);
+    return found == 3 * lookups + scans ? 0 : 1;
+}
+
+int runReconcileBenchmark(double millions, int accounts) {
+    long long transactions = static_cast<long long>(millions * 1000000);
+    if (transactions < 1 || accounts < 1) {
+        cout << "Usage: reconcile <millions of transactions> [accounts]" << endl;
+        return 1;
+    }
+    printf("{\"bench\":\"smart-wallet-reconcile\",\"users\":%d,\"transactions\":%lld}\n", accounts, transactions);
+    BenchReport report;
+    BenchRandom random(42);
+    BankingSystem bank(false);
+    report.start();
+    int perAccount = static_cast<int>(transactions / accounts + 1);
+    long timestamp = static_cast<long>(time(nullptr)) - 365L * 24 * 60 * 60;
+    for (int i = 0; i < accounts; i++) {
+        User* user = new User("Bench User", "USER" + to_string(1000 + i), "password", "1234",
+                              "user" + to_string(i) + "@example.com", "03001234567", "Street " + to_string(i), "Savings", Money());
+        user->accountNumber = benchAccountNumber(i);
+        user->balance = Money(1000000);
+        user->transactions.reserve(perAccount + 1);
+        user->transactions.addTransaction(1, TXN_ACCOUNT_CREATION, user->balance, user->balance, "", timestamp);
+        if (bank.userCount >= bank.capacity) {
+            bank.resizeArray();
+        }
+        bank.users[bank.userCount] = user;
+        bank.indexUser(bank.userCount);
+        bank.userCount++;
+    }
+    for (long long i = 0; i < transactions; i++) {
+        User* user = bank.users[random.below(accounts)];
+        Money amount(static_cast<long long>(random.next() % 500000) + 1);
+        unsigned short type = TXN_DEPOSIT;
+        if (random.next() % 2 == 0 && amount <= user->balance) {
+            type = TXN_WITHDRAW;
+            user->balance -= amount;
+        } else {
+            user->balance += amount;
+        }
+        user->transactions.addTransaction(static_cast<unsigned long long>(i + 2), type, amount, user->balance, "", timestamp + i / 1000);
+    }
+    report.finish("reconcile_generate", transactions);
+
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    long long rows = 0;
+    long long mismatches = 0;
+    report.start();
+    for (int i = 0; i < bank.userCount; i++) {
+        const TransactionHistory& history = bank.users[i]->transactions;
+        Money running;
+        for (int row = 0; row < history.getCount(); row++) {
+            if (table.has(history.types[row], TXF_CREDIT)) running += history.amounts[row];
+            if (table.has(history.types[row], TXF_DEBIT)) running -= history.amounts[row];
+            if (running != history.balances[row]) mismatches++;
+        }
+        if (running != bank.users[i]->balance) mismatches++;
+        rows += history.getCount();
+    }
+    report.finish("reconcile", rows);
+
+    long long inexact = 0;
+    report.start();
+    for (int i = 0; i < bank.userCount; i++) {
+        const TransactionHistory& history = bank.users[i]->transactions;
+        double running = 0;
+        for (int row = 0; row < history.getCount(); row++) {
+            double amount = static_cast<double>(history.amounts[row].cents) / 100;
+            if (table.has(history.types[row], TXF_CREDIT)) running += amount;
+            if (table.has(history.types[row], TXF_DEBIT)) running -= amount;
+            if (running != static_cast<double>(history.balances[row].cents) / 100) inexact++;
+        }
+    }
+    report.finish("reconcile_double", rows);
+
+    printf("{\"reconciled_rows\":%lld,\"mismatches\":%lld,\"double_inexact_rows\":%lld}\n", rows, mismatches, inexact);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && string(argv[1]) == "--durability") {
+        if (!DurabilityConfig::current().parse(argv[2])) {
+            cout << "Usage: --durability <sync|group|async>[:<window ms>] ..." << endl;
+            return 1;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    if ((argc == 6 || argc == 7) && string(argv[1]) == "generate") {
+        return generateBankData(argv[2], atoi(argv[3]), atoi(argv[4]), atoi(argv[5]), argc == 7 ? atoll(argv[6]) : 1);
+    }
+    if ((argc == 4 || argc == 5) && string(argv[1]) == "run") {
+        return runBenchmarks(argv[2], argv[3], argc == 5 ? atoll(argv[4]) : 100000);
+    }
+    if ((argc == 4 || argc == 5) && string(argv[1]) == "load_destroy") {
+        return runLoadDestroyBenchmark(argv[2], argv[3], argc == 5 ? atoi(argv[4]) : 3);
+    }
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "lookup") {
+        return runLookupBenchmark(atoi(argv[2]), argc == 4 ? atoll(argv[3]) : 1000000);
+    }
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "reconcile") {
+        return runReconcileBenchmark(atof(argv[2]), argc == 4 ? atoi(argv[3]) : 1000);
+    }
+    cout << "Usage:" << endl;
+    cout << "  wallet_bench generate <bank_data.txt> <users> <history per user> <scheduled payments> [seed]" << endl;
+    cout << "  wallet_bench [--durability <mode>] run <bank_data.txt> <work dir> [operations]" << endl;
+    cout << "  wallet_bench load_destroy <bank_data.txt> <work dir> [runs]" << endl;
+    cout << "  wallet_bench lookup <accounts> [lookups]" << endl;
+    cout << "  wallet_bench reconcile <millions of transactions> [accounts]" << endl;
+    return 1;
+}
@@ -0,0 +1,1463 @@
+#include "console.h"
+#include <iostream>
+#include <climits>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+// Fixed screens, written out whole.
+static const char BANNER[] =
+    "\n"
+    "***************************************************\n"
+    "*        SMART BANKING WALLET SYSTEM             *\n"
+    "***************************************************\n";
+
+static const char MAIN_MENU[] =
+    "+-------------------------------------------------+\n"
+    "|                   MAIN MENU                    |\n"
+    "+-------------------------------------------------+\n"
+    "|  1. Create New Account                         |\n"
+    "|  2. Login to Existing Account                  |\n"
+    "|  3. Exit System                                |\n"
+    "+-------------------------------------------------+\n";
+
+static const char DASHBOARD_TITLE[] =
+    "\n"
+    "===================================================\n"
+    "               WELCOME DASHBOARD                  \n"
+    "===================================================\n";
+
+static const char OPERATIONS_MENU[] =
+    "\n"
+    "+-------------------------------------------------+\n"
+    "|              BANKING OPERATIONS                |\n"
+    "+-------------------------------------------------+\n"
+    "|  1. Deposit Money                               |\n"
+    "|  2. Withdraw Money                              |\n"
+    "|  3. Transfer Funds                              |\n"
+    "|  4. View Account Details                        |\n"
+    "|  5. View Transaction History                    |\n"
+    "|  6. Undo Last Transaction                       |\n"
+    "|  7. Schedule Payment                            |\n"
+    "|  8. View Scheduled Payments                     |\n"
+    "|  9. Cancel Scheduled Payment                    |\n"
+    "| 10. Update Profile Information                  |\n"
+    "| 11. Log Out                                     |\n"
+    "+-------------------------------------------------+\n";
+
+static const char EXIT_MESSAGE[] =
+    "\n"
+    "===================================================\n"
+    "           THANK YOU FOR BANKING WITH US!         \n"
+    "                                                  \n"
+    "             See you again soon!                  \n"
+    "===================================================\n";
+
+static const char HISTORY_MENU[] =
+    "\n=== TRANSACTION HISTORY ===\n"
+    "+-------------------------------------------------+\n"
+    "|  1. All transactions                            |\n"
+    "|  2. Last N transactions                         |\n"
+    "|  3. Transactions between two dates              |\n"
+    "|  0. Back                                        |\n"
+    "+-------------------------------------------------+\n"
+    "Choose option (0-3): ";
+
+static const char HISTORY_HEADER[] =
+    "\n+----------------------------------------------------------------------------------------+\n"
+    "|                            TRANSACTION HISTORY                                       |\n"
+    "+----------------------------------------------------------------------------------------+\n";
+
+static const char HISTORY_FOOTER[] =
+    "+----------------------------------------------------------------------------------------+\n";
+
+static const char PAYMENTS_RULE[] =
+    "+----------------------------------------------------------------+\n";
+
+// Padding source for ScreenBuffer::pad.
+static const char SPACES[] = "                                                                ";
+
+ScreenBuffer& ScreenBuffer::add(long long value) {
+    char buf[24];
+    int i = sizeof(buf);
+    unsigned long long rest = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    do {
+        buf[--i] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+    } while (rest != 0);
+    if (value < 0) buf[--i] = '-';
+    text.append(buf + i, sizeof(buf) - i);
+    return *this;
+}
+
+ScreenBuffer& ScreenBuffer::pad(const char* s, size_t length, int width) {
+    size_t target = width > 0 ? static_cast<size_t>(width) : 0;
+    if (length >= target) {
+        text.append(s, target);
+        return *this;
+    }
+    text.append(s, length);
+    size_t fill = target - length;
+    while (fill > 0) {
+        size_t chunk = fill < sizeof(SPACES) - 1 ? fill : sizeof(SPACES) - 1;
+        text.append(SPACES, chunk);
+        fill -= chunk;
+    }
+    return *this;
+}
+
+void ScreenBuffer::flush(ostream& out) {
+    if (!text.empty()) out.write(text.data(), static_cast<streamsize>(text.size()));
+    out.flush();
+    text.clear();
+}
+
+int FdOutputBuffer::overflow(int c) {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    char one = static_cast<char>(c);
+    return xsputn(&one, 1) == 1 ? c : traits_type::eof();
+}
+
+streamsize FdOutputBuffer::xsputn(const char* s, streamsize n) {
+    streamsize done = 0;
+    while (done < n) {
+        ssize_t written = ::write(fd, s + done, static_cast<size_t>(n - done));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += written;
+    }
+    return done;
+}
+
+ostream& consoleOutput() {
+    static FdOutputBuffer buffer(STDOUT_FILENO);
+    static ostream stream(&buffer);
+    return stream;
+}
+
+ostream*& noticeStream() {
+    static ostream* stream = &cout;
+    return stream;
+}
+
+void printNotice(const string& message) {
+    ScreenBuffer line;
+    line.add(message).add("\n");
+    line.flush(*noticeStream());
+}
+
+WalletConsole::WalletConsole(BankingSystem& system) : bank(system), screens(consoleOutput()) {}
+
+void WalletConsole::show(ScreenBuffer& screen) {
+    if (&screen != &pending && !pending.text.empty()) {
+        pending.text += screen.text;
+        screen.text.clear();
+        pending.flush(screens);
+        return;
+    }
+    screen.flush(screens);
+}
+
+void WalletConsole::addBanner(ScreenBuffer& screen) {
+    screen.add(BANNER);
+}
+
+void WalletConsole::run() {
+    // Scheduled payments run while the menus wait for input; a screen in
+    // progress holds them off until it returns.
+    unique_lock<mutex> hold(bank.stateLock);
+    ostream* notices = noticeStream();
+    noticeStream() = &screens;
+    int choice;
+    ScreenBuffer screen;
+    do {
+        addBanner(screen);
+        addMainMenu(screen);
+        screen.add("Enter your choice (1-3): ");
+        show(screen);
+        hold.unlock();
+        cin >> choice;
+        hold.lock();
+        if (cin.fail()) {
+            cin.clear();
+            cin.ignore(10000, '\n');
+            choice = 0;
+        }
+        if (choice == 1) {
+            createAccount();
+        } else if (choice == 2) {
+            User* loggedInUser = login();
+            if (loggedInUser != nullptr) {
+                int dashChoice;
+                do {
+                    addDashboard(screen, loggedInUser);
+                    screen.add("Enter your choice (1-11): ");
+                    show(screen);
+                    hold.unlock();
+                    cin >> dashChoice;
+                    hold.lock();
+                    if (cin.fail()) {
+                        cin.clear();
+                        cin.ignore(10000, '\n');
+                        dashChoice = 0; 
+                    }
+                    if (dashChoice == 1) {
+                        depositMoney(loggedInUser);
+                    } else if (dashChoice == 2) {
+                        withdrawMoney(loggedInUser);
+                    } else if (dashChoice == 3) {
+                        transferFunds(loggedInUser);
+                    } else if (dashChoice == 4) {
+                        displayAccountInfo(loggedInUser);
+                    } else if (dashChoice == 5) {
+                        viewTransactionHistory(loggedInUser);
+                    } else if (dashChoice == 6) {
+                        undoLastTransaction(loggedInUser);
+                    } else if (dashChoice == 7) {
+                        schedulePayment(loggedInUser);
+                    } else if (dashChoice == 8) {
+                        viewScheduledPayments(loggedInUser);
+                    } else if (dashChoice == 9) {
+                        cancelScheduledPayment(loggedInUser);
+                    } else if (dashChoice == 10) {
+                        updateProfile(loggedInUser);
+                    } else if (dashChoice == 11) {
+                        pending.add("\nLogging out...\n");
+                        loggedInUser->addSecurityLog("LOGOUT");
+                    }
+                    else {
+                        pending.add("\nInvalid choice! Please enter a number between 1-11.\n");
+                    }
+                    if (dashChoice != 11) {
+                        cin.ignore(10000, '\n');
+                        pending.add("\nPress Enter to continue...");
+                        show(pending);
+                        hold.unlock();
+                        cin.get();
+                        hold.lock();
+                    }
+                } while (dashChoice != 11);
+            }
+        } else if (choice == 3) {
+            screen.add(EXIT_MESSAGE);
+            show(screen);
+        } else {
+            pending.add("\nInvalid choice! Please enter 1, 2, or 3.\n");
+        }
+        if (choice != 3) {
+            cin.ignore(10000, '\n');
+            pending.add("\nPress Enter to continue...");
+            show(pending);
+            hold.unlock();
+            cin.get();
+            hold.lock();
+        }
+    } while(choice != 3);
+    show(pending);
+    noticeStream() = notices;
+    hold.unlock();
+}
+
+bool WalletConsole::readAmount(Money& amount) {
+    double typed;
+    show(pending);
+    cin >> typed;
+    if (cin.fail()) return false;
+    amount = Money::fromDouble(typed);
+    return true;
+}
+
+string WalletConsole::padString(string text, int width) {
+    if (text.length() >= (size_t)width) {
+        return text.substr(0, width);
+    }
+    return text + string(width - text.length(), ' ');
+}
+
+void WalletConsole::printReceipt(unsigned short type, Money amount, Money balanceAfter, const string &otherAccount) {
+    ScreenBuffer screen;
+    screen.add("+-------------------------------------------------+\n"
+               "|  Transaction Recorded:                          |\n");
+    screen.add("|  Type: ").pad(TransactionTypeTable::instance().name(type), 37).add("|\n");
+    screen.add("|  Amount: PKR ").pad(amount, 30).add("|\n");
+    if (!otherAccount.empty()) {
+        screen.add("|  Other: ").pad(otherAccount, 33).add("|\n");
+    }
+    screen.add("|  New Balance: PKR ").pad(balanceAfter, 27).add("|\n");
+    screen.add("+-------------------------------------------------+\n");
+    show(screen);
+}
+
+bool WalletConsole::verifyTransactionPIN(User* user) {
+    string pin;
+    pending.add("+-------------------------------------------------+\n");
+    pending.add("|  Enter your 4-digit PIN (0 to cancel): ");
+    show(pending);
+    cin >> pin;
+    if (pin == "0") {
+        pending.add("|  Transaction cancelled by user.                 |\n");
+        pending.add("+-------------------------------------------------+\n");
+        return false;
+    }
+    if (user->verifyPIN(pin)) {
+        return true;
+    } else {
+        pending.add("|  Invalid PIN! ");
+        if (user->isLocked) {
+            pending.add("Account temporarily locked due to too many failed attempts.\n");
+            pending.add("|  Please try again after ").add(SecurityConfig::ACCOUNT_LOCKOUT_TIME)
+                   .add(" seconds.\n");
+            user->addSecurityLog("ACCOUNT_LOCKED", "Too many failed PIN attempts");
+        } else {
+            int attemptsLeft = SecurityConfig::MAX_LOGIN_ATTEMPTS - user->loginAttempts;
+            pending.add(attemptsLeft).add(" attempts remaining.\n");
+            user->addSecurityLog("FAILED_PIN_ATTEMPT", "Attempts: " + to_string(user->loginAttempts));
+        }
+        pending.add("|  Transaction cancelled.                         |\n");
+        pending.add("+-------------------------------------------------+\n");
+        return false;
+    }
+}
+
+bool WalletConsole::verifyPassword(User* user, const string& purpose) {
+    string password;
+    pending.add("+-------------------------------------------------+\n");
+    pending.add("|  Enter your password for ").add(padString(purpose, 20)).add("|\n");
+    pending.add("|  Password (0 to cancel): ");
+    show(pending);
+    cin >> password;
+    if (password == "0") {
+        pending.add("|  Operation cancelled by user.                   |\n");
+        pending.add("+-------------------------------------------------+\n");
+        return false;
+    }
+    if (user->verifyPassword(password)) {
+        return true;
+    } else {
+        pending.add("|  Invalid password! ");
+        if (user->isLocked) {
+            pending.add("Account temporarily locked.\n");
+            pending.add("|  Please try again after ").add(SecurityConfig::ACCOUNT_LOCKOUT_TIME)
+                   .add(" seconds.\n");
+            user->addSecurityLog("ACCOUNT_LOCKED", "Too many failed password attempts");
+        } else {
+            int attemptsLeft = SecurityConfig::MAX_LOGIN_ATTEMPTS - user->loginAttempts;
+            pending.add(attemptsLeft).add(" attempts remaining.\n");
+            user->addSecurityLog("FAILED_PASSWORD_ATTEMPT", "Purpose: " + purpose);
+        }
+        pending.add("|  Operation cancelled.                           |\n");
+        pending.add("+-------------------------------------------------+\n");
+        return false;
+    }
+}
+
+void WalletConsole::addMainMenu(ScreenBuffer& screen) {
+    screen.add(MAIN_MENU);
+}
+
+void WalletConsole::addDashboard(ScreenBuffer& screen, User* user) {
+    screen.add(DASHBOARD_TITLE);
+    addMiniInfo(screen, user);
+    screen.add(OPERATIONS_MENU);
+}
+
+void WalletConsole::createAccount() {
+    pending.add("\n=== CREATE NEW ACCOUNT ===\n");
+    string name, email, phone, address, accountType, password, pin;
+    Money initialBalance;
+    User tempUser;
+    while (true) {
+        cin.ignore();
+        pending.add("Enter Full Name (or 0 to cancel): ");
+        show(pending);
+        getline(cin, name);
+        if (name == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (bank.isValidName(name)) {
+            break;
+        } else {
+            pending.add("Invalid name! Name must be 2-50 characters with only letters, spaces, dots, and hyphens.\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter Email (or 0 to cancel): ");
+        show(pending);
+        getline(cin, email);
+        if (email == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (bank.isValidEmail(email) && bank.isEmailUnique(email)) {
+            break;
+        } else {
+            if (!bank.isValidEmail(email)) {
+                pending.add("Invalid email format! Please enter a valid email.\n");
+            } else {
+                pending.add("Email already exists! Please use a different email.\n");
+            }
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter Phone (or 0 to cancel): ");
+        show(pending);
+        getline(cin, phone);
+        if (phone == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (bank.isValidPhone(phone)) {
+            break;
+        } else {
+            pending.add("Invalid phone number! Phone must be 10-15 digits with optional +, -, spaces, (, ).\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter Address (or 0 to cancel): ");
+        show(pending);
+        getline(cin, address);
+        if (address == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (!address.empty() && address.length() <= 100) {
+            break;
+        } else {
+            pending.add("Invalid address! Address cannot be empty and must be under 100 characters.\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter Account Type (Savings/Current) or 0 to cancel: ");
+        show(pending);
+        getline(cin, accountType);
+        if (accountType == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (accountType == "Savings" || accountType == "Current") {
+            break;
+        } else {
+            pending.add("Invalid account type! Please enter either 'Savings' or 'Current'.\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter Initial Balance: ");
+        bool parsed = readAmount(initialBalance);
+        if (!parsed || !bank.isValidAmount(initialBalance)) {
+            pending.add("Invalid amount! Amount must be between 0 and 1,000,000.\n");
+            pending.add("Please try again.\n");
+            cin.clear();
+            cin.ignore(10000, '\n');
+        } else {
+            break;
+        }
+    }
+    while (true) {
+        pending.add("Enter Password (or 0 to cancel): ");
+        show(pending);
+        cin >> password;
+        if (password == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (bank.isValidPassword(password) && !tempUser.isWeakPassword(password)) {
+            break;
+        } else {
+            pending.add("Invalid password! Must be 4-20 characters and NOT weak.\n");
+            pending.add("Weak passwords like '1234', '0000', 'password', or repeated characters are NOT allowed.\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    while (true) {
+        pending.add("Enter 4-digit PIN (or 0 to cancel): ");
+        show(pending);
+        cin >> pin;
+        if (pin == "0") {
+            pending.add("Account creation cancelled.\n");
+            return;
+        }
+        if (bank.isValidPIN(pin) && !tempUser.isWeakPIN(pin)) {
+            break;
+        } else {
+            pending.add("Invalid PIN! Must be exactly 4 digits and NOT weak.\n");
+            pending.add("Weak PINs like 0000, 1111, 1234, 4321, or repeated digits are NOT allowed.\n");
+            pending.add("Please try again.\n");
+        }
+    }
+    User* newUser = nullptr;
+    OperationStatus status = bank.openAccount(name, email, phone, address, accountType, initialBalance, password, pin, newUser);
+    if (status != OP_OK) {
+        pending.add("Account could not be created: ").add(operationStatusText(status)).add(".\n");
+        return;
+    }
+    bank.commit();
+    pending.add("\n+=================================================+\n");
+    pending.add("|          ACCOUNT CREATED SUCCESSFULLY         |\n");
+    pending.add("+-------------------------------------------------+\n");
+    pending.add("|  User ID: ").add(padString(newUser->userID, 34)).add("|\n");
+    pending.add("|  Account No: ").add(padString(newUser->accountNumber, 31)).add("|\n");
+    pending.add("+=================================================+\n");
+}
+
+User* WalletConsole::login() {
+    pending.add("\n=== LOGIN ===\n");
+    string userID, password;
+    while (true) {
+        pending.add("Enter User ID (or 0 to cancel): ");
+        show(pending);
+        cin >> userID;
+        if (userID == "0") {
+            pending.add("Login cancelled.\n");
+            return nullptr;
+        }
+        int userIndex = bank.findUserByUserID(userID);
+        if (userIndex == -1) {
+            int attempts = bank.recordInvalidUserID();
+            pending.add("Invalid User ID! Please try again.\n");
+            if (attempts >= 3) {
+                pending.add("Too many failed attempts. System will exit.\n");
+                exit(0);
+            }
+        } else {
+            break;
+        }
+    }
+    User* user = bank.users[bank.findUserByUserID(userID)];
+    while (true) {
+        pending.add("Enter Password (or 0 to cancel): ");
+        show(pending);
+        cin >> password;
+        if (password == "0") {
+            pending.add("Login cancelled.\n");
+            return nullptr;
+        }
+        if (user->verifyPassword(password)) {
+            bank.clearInvalidUserIDs();
+            user->addSecurityLog("LOGIN_SUCCESS");
+            pending.add("Login successful! Welcome ").add(user->name).add("\n");
+            return user;
+        } else {
+            pending.add("Invalid password! ");
+            if (user->isLocked) {
+                pending.add("Account temporarily locked. Please try again after ")
+                       .add(SecurityConfig::ACCOUNT_LOCKOUT_TIME).add(" seconds.\n");
+                return nullptr;
+            } else {
+                int attemptsLeft = SecurityConfig::MAX_LOGIN_ATTEMPTS - user->loginAttempts;
+                pending.add(attemptsLeft).add(" attempts remaining.\n");
+                if (attemptsLeft <= 0) {
+                    return nullptr;
+                }
+            }
+        }
+    }
+}
+
+void WalletConsole::depositMoney(User* user) {
+    pending.add("\n=== DEPOSIT MONEY ===\n");
+    Money amount;
+    bool validAmount = false;
+    while (!validAmount) {
+        pending.add("Enter amount to deposit (0 to cancel): PKR ");
+        bool parsed = readAmount(amount);
+        if (parsed && amount.cents == 0) { 
+            pending.add("Deposit cancelled.\n");
+            return;
+        }
+        if (!parsed || !bank.isValidAmount(amount)) {
+            pending.add("Invalid amount! Amount must be between 0 and 1,000,000.\n");
+            pending.add("Please try again.\n");
+            cin.clear();
+            cin.ignore(10000, '\n');
+        } else {
+            validAmount = true;
+        }
+    }
+    bool pinVerified = false;
+    int pinAttempts = 0;
+    while (!pinVerified && pinAttempts < 3) {
+        if (verifyTransactionPIN(user)) {
+            pinVerified = true;
+        } else {
+            pinAttempts++;
+            if (pinAttempts < 3 && !user->isLocked) {
+                pending.add("Try again? (y/n): ");
+                char choice;
+                show(pending);
+                cin >> choice;
+                if (choice != 'y' && choice != 'Y') {
+                    break;
+                }
+            }
+        }
+    }
+    if (!pinVerified) {
+        pending.add("Transaction cancelled.\n");
+        return;
+    }
+    bank.applyDeposit(user, amount);
+    printReceipt(TXN_DEPOSIT, amount, user->balance);
+    bank.commit();
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::withdrawMoney(User* user) {
+    pending.add("\n=== WITHDRAW MONEY ===\n");
+    Money amount;
+    bool validAmount = false;
+    while (!validAmount) {
+        pending.add("Enter amount to withdraw (0 to cancel): PKR ");
+        bool parsed = readAmount(amount);
+        if (parsed && amount.cents == 0) { 
+            pending.add("Withdrawal cancelled.\n");
+            return;
+        }
+        if (!parsed || !bank.isValidAmount(amount)) {
+            pending.add("Invalid amount! Amount must be between 0 and 1,000,000.\n");
+            pending.add("Please try again.\n");
+            cin.clear();
+            cin.ignore(10000, '\n');
+        } else if (amount > user->balance) {
+            pending.add("Insufficient balance! Your balance is PKR ")
+                   .add(formatBalance(user->balance)).add("\n");
+            pending.add("Please enter a smaller amount: ");
+        } else {
+            validAmount = true;
+        }
+    }
+    bool pinVerified = false;
+    int pinAttempts = 0;
+    while (!pinVerified && pinAttempts < 3) {
+        if (verifyTransactionPIN(user)) {
+            pinVerified = true;
+        } else {
+            pinAttempts++;
+            if (pinAttempts < 3 && !user->isLocked) {
+                pending.add("Try again? (y/n): ");
+                char choice;
+                show(pending);
+                cin >> choice;
+                if (choice != 'y' && choice != 'Y') {
+                    break;
+                }
+            }
+        }
+    }
+    if (!pinVerified) {
+        pending.add("Transaction cancelled.\n");
+        return;
+    }
+    bank.applyWithdrawal(user, amount);
+    printReceipt(TXN_WITHDRAW, amount, user->balance);
+    bank.commit();
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::transferFunds(User* user) {
+    pending.add("\n=== TRANSFER FUNDS ===\n");
+    string toAccount;
+    Money amount;
+    bool validAccount = false;
+    bool validAmount = false;
+    while (!validAccount) {
+        pending.add("Enter recipient account number (or 0 to cancel): ");
+        show(pending);
+        cin >> toAccount;
+        if (toAccount == "0") { 
+            pending.add("Transfer cancelled.\n");
+            return;
+        }
+        int toUserIndex = bank.findUserByAccountNumber(toAccount);
+        if (toUserIndex == -1) {
+            pending.add("Recipient account not found! Please try again.\n");
+        } else if (toAccount == user->accountNumber) {
+            pending.add("Cannot transfer to your own account! Please enter a different account.\n");
+        } else {
+            validAccount = true;
+        }
+    }
+    while (!validAmount) {
+        pending.add("Enter amount to transfer (0 to cancel): PKR ");
+        bool parsed = readAmount(amount);
+        if (parsed && amount.cents == 0) { 
+            pending.add("Transfer cancelled.\n");
+            return;
+        }
+        if (!parsed || !bank.isValidAmount(amount)) {
+            pending.add("Invalid amount! Amount must be between 0 and 1,000,000.\n");
+            pending.add("Please try again.\n");
+            cin.clear();
+            cin.ignore(10000, '\n');
+        } else if (amount > user->balance) {
+            pending.add("Insufficient balance! Your balance is PKR ")
+                   .add(formatBalance(user->balance)).add("\n");
+            pending.add("Please enter a smaller amount: ");
+        } else {
+            validAmount = true;
+        }
+    }
+    bool pinVerified = false;
+    int pinAttempts = 0;
+    while (!pinVerified && pinAttempts < 3) {
+        if (verifyTransactionPIN(user)) {
+            pinVerified = true;
+        } else {
+            pinAttempts++;
+            if (pinAttempts < 3 && !user->isLocked) {
+                pending.add("Try again? (y/n): ");
+                char choice;
+                show(pending);
+                cin >> choice;
+                if (choice != 'y' && choice != 'Y') {
+                    break;
+                }
+            }
+        }
+    }
+    if (!pinVerified) {
+        pending.add("Transaction cancelled.\n");
+        return;
+    }
+    User* toUser = bank.users[bank.findUserByAccountNumber(toAccount)];
+    bank.applyTransfer(user, toUser, amount);
+    printReceipt(TXN_TRANSFER_OUT, amount, user->balance, toAccount);
+    pending.add("Transfer completed successfully to account: ").add(toAccount).add("\n");
+    bank.commit();
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+bool WalletConsole::readDate(const string& prompt, long long& when) {
+    string text;
+    pending.add(prompt);
+    show(pending);
+    cin >> text;
+    int year, month, day;
+    if (sscanf(text.c_str(), "%d-%d-%d", &year, &month, &day) != 3 || month < 1 || month > 12 || day < 1 || day > 31) {
+        pending.add("Invalid date! Use YYYY-MM-DD.\n");
+        return false;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = day;
+    date.tm_isdst = -1;
+    when = static_cast<long long>(mktime(&date));
+    return true;
+}
+
+void WalletConsole::viewTransactionHistory(User* user) {
+    ScreenBuffer screen;
+    screen.add(HISTORY_MENU);
+    show(screen);
+    int choice;
+    show(pending);
+    cin >> choice;
+    if (cin.fail()) {
+        cin.clear();
+        cin.ignore(10000, '\n');
+        choice = 0;
+    }
+    if (choice == 1) {
+        viewHistoryPages(user, LLONG_MIN, LLONG_MAX, 0, true);
+    } else if (choice == 2) {
+        int n;
+        pending.add("How many recent transactions? ");
+        show(pending);
+        cin >> n;
+        if (cin.fail() || n <= 0) {
+            cin.clear();
+            pending.add("Invalid number!\n");
+        } else {
+            // The rows asked for are shown at once; only the full history
+            // and date ranges are paged.
+            if (n > user->getTransactionCount()) n = user->getTransactionCount();
+            int* rows = new int[n];
+            int found = user->transactions.queryLast(n, rows);
+            displayTransactionRows(user, rows, found);
+            delete[] rows;
+        }
+    } else if (choice == 3) {
+        long long from, to;
+        if (readDate("From date (YYYY-MM-DD): ", from) && readDate("To date (YYYY-MM-DD): ", to)) {
+            to += 24 * 60 * 60 - 1;
+            viewHistoryPages(user, from, to);
+        }
+    }
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::viewHistoryPages(User* user, long long from, long long to, int skip, bool latestFirst) {
+    int total = user->transactions.countRange(from, to) - skip;
+    if (total <= 0) {
+        pending.add((from == LLONG_MIN ? "\nNo transactions found." : "\nNo transactions in that period."))
+               .add("\n");
+        return;
+    }
+    int pages = (total + BankingSystem::HISTORY_PAGE_SIZE - 1) / BankingSystem::HISTORY_PAGE_SIZE;
+    int rows[BankingSystem::HISTORY_PAGE_SIZE];
+    int page = latestFirst ? pages - 1 : 0;
+    ScreenBuffer screen;
+    while (true) {
+        int found = user->transactions.queryRange(from, to, skip + page * BankingSystem::HISTORY_PAGE_SIZE, BankingSystem::HISTORY_PAGE_SIZE, rows);
+        addTransactionRows(screen, user, rows, found);
+        screen.add("Page ").add(page + 1).add(" of ").add(pages).add(" (").add(total).add(" transactions)\n");
+        if (pages > 1) screen.add("n = next, p = previous, q = done: ");
+        show(screen);
+        if (pages == 1) return;
+        char action = 'q';
+        show(pending);
+        cin >> action;
+        if (action == 'n' || action == 'N') {
+            if (page + 1 < pages) page++;
+        } else if (action == 'p' || action == 'P') {
+            if (page > 0) page--;
+        } else {
+            return;
+        }
+    }
+}
+
+void WalletConsole::undoLastTransaction(User* user) {
+    pending.add("\n=== UNDO LAST TRANSACTION ===\n");
+    showUndoableTransactions(user);
+    if (!user->canUndo()) {
+        cin.ignore(10000, '\n');
+        pending.add("\nPress Enter to continue...");
+        show(pending);
+        cin.get();
+        return;
+    } 
+    bool pinVerified = false;
+    int pinAttempts = 0;
+    while (!pinVerified && pinAttempts < 3) {
+        if (verifyTransactionPIN(user)) {
+            pinVerified = true;
+        } else {
+            pinAttempts++;
+            if (pinAttempts < 3 && !user->isLocked) {
+                pending.add("Try again? (y/n): ");
+                char choice;
+                show(pending);
+                cin >> choice;
+                if (choice != 'y' && choice != 'Y') {
+                    break;
+                }
+            }
+        }
+    }
+    if (!pinVerified) {
+        pending.add("Transaction cancelled.\n");
+        cin.ignore(10000, '\n');
+        pending.add("\nPress Enter to continue...");
+        show(pending);
+        cin.get();
+        return;
+    }
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    UndoRing::Entry* last = user->undoRing.newest();
+    unsigned short type = last->type;
+    Money amount = last->amount;
+    string otherAccount = last->otherAccount;
+    Money oldBalance = user->balance;
+    OperationStatus status = bank.undoLast(user);
+    if (status == OP_UNDO_EXPIRED) {
+        pending.add("Cannot undo - transaction is older than ").add(SecurityConfig::UNDO_WINDOW)
+               .add(" seconds.\n");
+    } else {
+        pending.add("Undoing last transaction: ").add(table.name(type)).add(" of PKR ")
+               .add(formatBalance(amount)).add("\n");
+    }
+    if (status == OP_NOT_UNDOABLE && table.has(type, TXF_SCHEDULED)) {
+        pending.add("Cannot undo scheduled payments once they are scheduled.\n");
+        pending.add("You need to cancel the scheduled payment instead.\n");
+    } else if (status == OP_NOT_UNDOABLE && table.has(type, TXF_TRANSFER)) {
+        pending.add("Cannot undo - the other account's side of this transfer can no longer be reversed.\n");
+    } else if (status == OP_NOT_UNDOABLE) {
+        pending.add("Cannot undo this type of transaction.\n");
+    } else if (status == OP_INSUFFICIENT_FUNDS) {
+        pending.add("Cannot undo - it would leave a balance below zero.\n");
+    } else if (status == OP_OK) {
+        if (type == TXN_DEPOSIT) {
+            pending.add("Deposit undone. ").add(formatBalance(amount)).add(" deducted from account.\n");
+        } else if (type == TXN_WITHDRAW) {
+            pending.add("Withdrawal undone. ").add(formatBalance(amount)).add(" added back to account.\n");
+        } else if (type == TXN_TRANSFER_IN) {
+            pending.add("Transfer undone. ").add(formatBalance(amount)).add(" returned to ")
+                   .add(otherAccount).add(".\n");
+        } else {
+            pending.add("Transfer undone. ").add(formatBalance(amount)).add(" added back to account.\n");
+        }
+        pending.add("Balance changed from PKR ").add(formatBalance(oldBalance)).add(" to PKR ")
+               .add(formatBalance(user->balance)).add("\n");
+        pending.add("Undo completed successfully!\n");
+    }
+    bank.commit();
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::schedulePayment(User* user) {
+    pending.add("\n=== SCHEDULE PAYMENT ===\n");
+    string toAccount;
+    Money amount;
+    int unitChoice;
+    long long value;
+    bool validAccount = false;
+    bool validAmount = false;
+    while (!validAccount) {
+        pending.add("Enter recipient account number (or 0 to cancel): ");
+        show(pending);
+        cin >> toAccount;
+        if (toAccount == "0") { 
+            pending.add("Payment scheduling cancelled.\n");
+            return;
+        }
+        int toUserIndex = bank.findUserByAccountNumber(toAccount);
+        if (toUserIndex == -1) {
+            pending.add("Recipient account not found! Please try again.\n");
+        } else if (toAccount == user->accountNumber) {
+            pending.add("Cannot schedule payment to your own account!\n");
+        } else {
+            validAccount = true;
+        }
+    }
+    while (!validAmount) {
+        pending.add("Enter amount to schedule (0 to cancel): PKR ");
+        bool parsed = readAmount(amount);
+        if (parsed && amount.cents == 0) { 
+            pending.add("Payment scheduling cancelled.\n");
+            return;
+        }
+        if (!parsed || !bank.isValidAmount(amount)) {
+            pending.add("Invalid amount! Please try again.\n");
+            cin.clear();
+            cin.ignore(10000, '\n');
+        } else if (amount > user->balance) {
+            pending.add("Insufficient balance! Your balance: PKR ").add(formatBalance(user->balance))
+                   .add("\n");
+            pending.add("Would you like to deposit money now? (yes/no): ");
+            string choice;
+            show(pending);
+            cin >> choice;
+            if (choice == "yes" || choice == "y") {
+                depositMoney(user);
+                if (amount > user->balance) {
+                    pending.add("Still insufficient funds. Payment cancelled.\n");
+                    return;
+                } else {
+                    validAmount = true;
+                }
+            } else {
+                return;
+            }
+        } else {
+            validAmount = true;
+        }
+    }
+    if (amount > Money(500000)) {
+        pending.add("Large payment detected. Additional verification required.\n");
+        if (!verifyPassword(user, "large scheduled payment")) {
+            return;
+        }
+    }
+    bool pinVerified = false;
+    int pinAttempts = 0;
+    while (!pinVerified && pinAttempts < 3) {
+        if (verifyTransactionPIN(user)) {
+            pinVerified = true;
+        } else {
+            pinAttempts++;
+            if (pinAttempts < 3 && !user->isLocked) {
+                pending.add("Try again? (y/n): ");
+                char choice;
+                show(pending);
+                cin >> choice;
+                if (choice != 'y' && choice != 'Y') {
+                    break;
+                }
+            }
+        }
+    }
+    if (!pinVerified) {
+        pending.add("Transaction cancelled.\n");
+        return;
+    }
+    pending.add("\n+-------------------------------------------------+\n");
+    pending.add("|         WHEN SHOULD THIS PAYMENT RUN?           |\n");
+    pending.add("+-------------------------------------------------+\n");
+    pending.add("|  1. After N minutes                             |\n");
+    pending.add("|  2. After N hours                               |\n");
+    pending.add("|  3. After N days                                |\n");
+    pending.add("|  4. After N months (approx 30 days each)        |\n");
+    pending.add("|  0. Cancel                                      |\n");
+    pending.add("+-------------------------------------------------+\n");
+    while (true) {
+        pending.add("Choose option (0-4): ");
+        show(pending);
+        cin >> unitChoice;
+        if (unitChoice == 0) {
+            pending.add("Payment scheduling cancelled.\n");
+            return;
+        }
+        if (unitChoice >= 1 && unitChoice <= 4) break;
+        pending.add("Invalid choice!\n");
+    }
+    while (true) {
+        pending.add("Enter N (how many, or 0 to cancel): ");
+        show(pending);
+        cin >> value;
+        if (value == 0) { 
+            pending.add("Payment scheduling cancelled.\n");
+            return;
+        }
+        if (value > 0) break;
+        pending.add("Value must be positive.\n");
+    }
+    long long offsetSeconds = 0;
+    if (unitChoice == 1) offsetSeconds = value * 60;
+    else if (unitChoice == 2) offsetSeconds = value * 60 * 60;
+    else if (unitChoice == 3) offsetSeconds = value * 24 * 60 * 60;
+    else if (unitChoice == 4) offsetSeconds = value * 30 * 24 * 60 * 60;
+    long executeTime = time(nullptr) + offsetSeconds;
+    long long repeat;
+    pending.add("Repeat every how many of the same unit? (0 for a one-off payment): ");
+    show(pending);
+    cin >> repeat;
+    if (cin.fail() || repeat < 0) {
+        cin.clear();
+        cin.ignore(10000, '\n');
+        repeat = 0;
+    }
+    char repeatUnit = PaymentPriorityQueue::RECUR_NONE;
+    long long every = 0;
+    int maxRuns = 0;
+    long long endAt = 0;
+    if (repeat > 0) {
+        if (unitChoice == 1) every = repeat * 60;
+        else if (unitChoice == 2) every = repeat * 60 * 60;
+        else every = repeat;
+        if (every > 0x7fffffff) {
+            pending.add("Repeat interval too long. Payment scheduling cancelled.\n");
+            return;
+        }
+        repeatUnit = unitChoice == 3 ? PaymentPriorityQueue::RECUR_DAYS
+                   : unitChoice == 4 ? PaymentPriorityQueue::RECUR_MONTHS : PaymentPriorityQueue::RECUR_SECONDS;
+        pending.add("Stop after how many payments? (0 for no limit): ");
+        show(pending);
+        cin >> maxRuns;
+        if (cin.fail() || maxRuns < 0) {
+            cin.clear();
+            cin.ignore(10000, '\n');
+            maxRuns = 0;
+        }
+        string endText;
+        pending.add("Last date to pay (YYYY-MM-DD, or 0 for none): ");
+        show(pending);
+        cin >> endText;
+        if (endText != "0") {
+            int year, month, day;
+            if (sscanf(endText.c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+                pending.add("Invalid date! Payment scheduling cancelled.\n");
+                return;
+            }
+            struct tm date;
+            memset(&date, 0, sizeof(date));
+            date.tm_year = year - 1900;
+            date.tm_mon = month - 1;
+            date.tm_mday = day;
+            date.tm_hour = 23;
+            date.tm_min = 59;
+            date.tm_sec = 59;
+            date.tm_isdst = -1;
+            endAt = static_cast<long long>(mktime(&date));
+        }
+    }
+    string paymentID;
+    if (bank.applySchedule(user, toAccount, amount, executeTime, paymentID, repeatUnit, static_cast<int>(every), maxRuns, endAt) != OP_OK) {
+        pending.add("Invalid schedule! The last date must not be before the first payment.\n");
+        return;
+    }
+    pending.add("\nPayment scheduled successfully!\n");
+    pending.add("Payment ID: ").add(paymentID).add("\n");
+    pending.add("Will execute after ").add(value).add(" ");
+    if (unitChoice == 1) pending.add("minute(s)");
+    else if (unitChoice == 2) pending.add("hour(s)");
+    else if (unitChoice == 3) pending.add("day(s)");
+    else pending.add("month(s)");
+    if (repeat > 0) {
+        pending.add(", then every ").add(repeat).add(" of the same");
+        if (maxRuns > 0) pending.add(" (").add(maxRuns).add(" payments in all)");
+    }
+    pending.add("\n");
+    bank.commit();
+    cin.ignore(10000, '\n');
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::cancelScheduledPayment(User* user) {
+    pending.add("\n=== CANCEL SCHEDULED PAYMENT ===\n");
+    bool hasPayments = false;
+    for (int i = 0; i < bank.scheduledPayments.size(); i++) {
+        if (bank.scheduledPayments.at(i)->fromAccount == user->accountNumber) {
+            hasPayments = true;
+            break;
+        }
+    }
+    if (!hasPayments) {
+        pending.add("You have no scheduled payments to cancel.\n");
+        cin.ignore(10000, '\n');
+        pending.add("\nPress Enter to continue...");
+        show(pending);
+        cin.get();
+        return;
+    }
+    viewScheduledPayments(user);
+    string paymentID;
+    pending.add("Enter Payment ID to cancel (or 0 to cancel): ");
+    show(pending);
+    cin.ignore(); 
+    getline(cin, paymentID);
+    paymentID.erase(0, paymentID.find_first_not_of(" \t\n\r\f\v"));
+    paymentID.erase(paymentID.find_last_not_of(" \t\n\r\f\v") + 1);
+    if (paymentID == "0") {
+        pending.add("Cancellation aborted by user.\n");
+        pending.add("\nPress Enter to continue...");
+        show(pending);
+        cin.get();
+        return;
+    }
+    if (paymentID.empty()) {
+        pending.add("No Payment ID entered. Cancellation aborted.\n");
+        pending.add("\nPress Enter to continue...");
+        show(pending);
+        cin.get();
+        return;
+    }
+    pending.add("Searching for Payment ID: '").add(paymentID).add("'\n");
+    PaymentPriorityQueue::PQNode* match = bank.scheduledPayments.find(paymentID);
+    if (match != nullptr && match->fromAccount == user->accountNumber) {
+        pending.add("Found payment: ").add(match->id).add(" - ").add(match->toAccount).add(" - PKR ")
+               .add(formatBalance(match->amount)).add("\n");
+    }
+    if (bank.applyCancel(user, paymentID) == OP_OK) {
+        pending.add("\n Scheduled payment cancelled successfully!\n");
+        pending.add("Payment ID: ").add(paymentID).add(" has been removed.\n");
+        bank.commit();
+    } else {
+        pending.add("\n Payment ID '").add(paymentID)
+               .add("' not found or you don't have permission to cancel it.\n");
+        pending.add("Please check the Payment ID and try again.\n");
+        pending.add("Make sure to copy the EXACT Payment ID shown in the list above.\n");
+    }
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::updateProfile(User* user) {
+    pending.add("\n=== UPDATE PROFILE ===\n");
+    if (!verifyPassword(user, "profile update")) {
+        return;
+    }
+    int choice;
+    do {
+        pending.add("\n+-------------------------------------------------+\n");
+        pending.add("|              UPDATE PROFILE                    |\n");
+        pending.add("+-------------------------------------------------+\n");
+        pending.add("|  1. Update Email                               |\n");
+        pending.add("|  2. Update Phone                               |\n");
+        pending.add("|  3. Update Address                             |\n");
+        pending.add("|  4. Update Password                            |\n");
+        pending.add("|  5. Update PIN                                 |\n");
+        pending.add("|  6. Back to Main Menu                          |\n");
+        pending.add("+-------------------------------------------------+\n");
+        pending.add("Enter your choice: ");
+        show(pending);
+        cin >> choice;
+        cin.ignore();
+        switch (choice) {
+            case 1: {
+                string newEmail, currentEmail;
+                pending.add("Enter current email for verification (or 0 to cancel): ");
+                show(pending);
+                getline(cin, currentEmail);
+                if (currentEmail == "0") {
+                    pending.add("Update cancelled.\n");
+                    break;
+                }
+                if (currentEmail != user->email) {
+                    pending.add("Email verification failed! Cannot update.\n");
+                    break;
+                }
+                pending.add("Enter new email (or 0 to cancel): ");
+                show(pending);
+                getline(cin, newEmail);
+                if (newEmail == "0") {
+                    pending.add("Update cancelled.\n");
+                    break;
+                }
+                OperationStatus status = bank.changeEmail(user, newEmail);
+                if (status == OP_EMAIL_TAKEN) {
+                    pending.add("Email already exists! Please use a different email.\n");
+                    break;
+                }
+                if (status == OP_OK) {
+                    pending.add("Email updated successfully!\n");
+                } else {
+                    pending.add("Invalid email!\n");
+                }
+                break;
+            }
+            case 2: {
+                string newPhone, currentPhone;
+                pending.add("Enter current phone for verification (or 0 to cancel): ");
+                show(pending);
+                getline(cin, currentPhone);
+                if (currentPhone == "0") {
+                    pending.add("Update cancelled.\n");
+                    break;
+                }
+                if (currentPhone != user->phone) {
+                    pending.add("Phone verification failed! Cannot update.\n");
+                    break;
+                }
+                pending.add("Enter new phone (or 0 to cancel): ");
+                show(pending);
+                getline(cin, newPhone);
+                if (newPhone == "0") {
+                    pending.add("Update cancelled.\n");
+                    break;
+                }
+                if (user->setPhone(newPhone)) {
+                    pending.add("Phone updated successfully!\n");
+                } else {
+                    pending.add("Invalid phone!\n");
+                }
+                break;
+            }
+            case 3: {
+                string newAddress;
+                pending.add("Enter new address (or 0 to cancel): ");
+                show(pending);
+                getline(cin, newAddress);
+                if (newAddress == "0") {
+                    pending.add("Update cancelled.\n");
+                    break;
+                }
+                if (user->setAddress(newAddress)) {
+                    pending.add("Address updated successfully!\n");
+                } else {
+                    pending.add("Invalid address!\n");
+                }
+                break;
+            }
+            case 4: {
+                pending.add("For security, password updates require calling bank helpline.\n");
+                pending.add("Please call 1-800-BANK-HELP\n");
+                break;
+            }
+            case 5: {
+                pending.add("For security, PIN updates require calling bank helpline.\n");
+                pending.add("Please call 1-800-BANK-HELP\n");
+                break;
+            }
+            case 6:
+                pending.add("Returning to main menu...\n");
+                break;
+            default:
+                pending.add("Invalid choice!\n");
+        }
+    } while (choice != 6);
+    bank.commit();
+    pending.add("\nPress Enter to continue...");
+    show(pending);
+    cin.get();
+}
+
+void WalletConsole::viewScheduledPayments(User* user) {
+    pending.add("\n=== SCHEDULED PAYMENTS ===\n");
+    PaymentPriorityQueue::PQNode** userPayments = new PaymentPriorityQueue::PQNode*[bank.scheduledPayments.size() + 1];
+    int userPaymentCount = 0;
+    for (int i = 0; i < bank.scheduledPayments.size(); i++) {
+        if (bank.scheduledPayments.at(i)->fromAccount == user->accountNumber) {
+            userPayments[userPaymentCount++] = bank.scheduledPayments.at(i);
+        }
+    }
+    PaymentPriorityQueue::sortByExecution(userPayments, userPaymentCount);
+    ScreenBuffer screen;
+    screen.add(PAYMENTS_RULE);
+    screen.add("|                      SCHEDULED PAYMENTS                      |\n");
+    screen.add(PAYMENTS_RULE);
+    for (int i = 0; i < userPaymentCount; i++) {
+        PaymentPriorityQueue::PQNode* current = userPayments[i];
+        char timeStr[32];
+        ctime_r(&current->executeAt, timeStr);
+        timeStr[strcspn(timeStr, "\n")] = '\0';
+        screen.add("| Payment #").add(i + 1).add("                                          |\n");
+        screen.add("| Payment ID: ").add(current->id).add("\n");
+        screen.add("| To Account: ").add(current->toAccount).add("\n");
+        screen.add("| Amount: PKR ").add(current->amount).add("\n");
+        screen.add("| Scheduled Time: ").add(timeStr).add("\n");
+        if (current->recurring()) {
+            screen.add("| Repeats: every ").add(current->every).add(" ")
+                  .add(current->unit == PaymentPriorityQueue::RECUR_MONTHS ? "month(s)" : current->unit == PaymentPriorityQueue::RECUR_DAYS ? "day(s)" : "second(s)");
+            if (current->maxRuns > 0) screen.add(", payment ").add(current->fired + 1).add(" of ").add(current->maxRuns);
+            if (current->endAt != 0) {
+                time_t endAt = static_cast<time_t>(current->endAt);
+                struct tm local;
+                char endDate[16];
+                strftime(endDate, sizeof(endDate), "%Y-%m-%d", localtime_r(&endAt, &local));
+                screen.add(", until ").add(endDate);
+            }
+            screen.add("\n");
+        }
+        screen.add(PAYMENTS_RULE);
+    }
+    delete[] userPayments;
+    if (userPaymentCount == 0) {
+        screen.add("|               No scheduled payments found.                 |\n");
+    } else {
+        screen.add("| Total: ").add(userPaymentCount).add(" scheduled payment(s) found.               |\n");
+    }
+    screen.add(PAYMENTS_RULE);
+    show(screen);
+}
+
+void WalletConsole::showUndoableTransactions(User* user) {
+    if (user->undoRing.isEmpty()) {
+        pending.add("No transactions available to undo.\n");
+        return;
+    }
+    UndoRing::Entry* last = user->undoRing.newest();
+    long now = time(nullptr);
+    long timeDiff = now - last->timestamp;
+    bool canUndo = (timeDiff <= SecurityConfig::UNDO_WINDOW);
+    char line[64];
+    ScreenBuffer screen;
+    screen.add("\n+-------------------------------------------------+\n"
+               "|              LAST TRANSACTION                  |\n"
+               "+-------------------------------------------------+\n");
+    screen.add("|  Type: ").pad(TransactionTypeTable::instance().name(last->type), 38).add("|\n");
+    screen.add("|  Amount: PKR ").pad(last->amount, 31).add("|\n");
+    int length = snprintf(line, sizeof(line), "%ld seconds ago", timeDiff);
+    screen.add("|  Time: ").pad(line, length, 37).add("|\n");
+    if (canUndo) {
+        screen.add("|  Status: ").pad("CAN BE UNDONE", 13, 35).add("|\n");
+        length = snprintf(line, sizeof(line), "%ld seconds", static_cast<long>(SecurityConfig::UNDO_WINDOW) - timeDiff);
+        screen.add("|  Time left: ").pad(line, length, 32).add("|\n");
+    } else {
+        screen.add("|  Status: ").pad("EXPIRED - CANNOT UNDO", 21, 35).add("|\n");
+    }
+    screen.add("+-------------------------------------------------+\n");
+    show(screen);
+}
+
+void WalletConsole::displayAccountInfo(User* user) {
+    ScreenBuffer screen;
+    screen.add("+=================================================+\n"
+               "|                  ACCOUNT DETAILS                |\n"
+               "+-------------------------------------------------+\n");
+    screen.add("|  Account No: ").pad(user->accountNumber, 31).add("|\n");
+    screen.add("|  Name: ").pad(user->name, 37).add("|\n");
+    screen.add("|  User ID: ").pad(user->userID, 34).add("|\n");
+    screen.add("|  Email: ").pad(user->email, 36).add("|\n");
+    screen.add("|  Phone: ").pad(user->phone, 36).add("|\n");
+    screen.add("|  Address: ").pad(user->address, 34).add("|\n");
+    screen.add("|  Account Type: ").pad(user->accountType, 29).add("|\n");
+    screen.add("|  Balance: PKR ").pad(user->balance, 30).add("|\n");
+    screen.add("|  Created: ").pad(user->dateCreated, 34).add("|\n");
+    if (user->isLocked) {
+        screen.add("|  STATUS: ACCOUNT TEMPORARILY LOCKED            |\n");
+    }
+    screen.add("+=================================================+\n");
+    show(screen);
+}
+
+void WalletConsole::addMiniInfo(ScreenBuffer& screen, User* user) {
+    screen.add("+-------------------------------------------------+\n");
+    screen.add("|  Account: ").pad(user->accountNumber, 34).add("|\n");
+    screen.add("|  Name: ").pad(user->name, 37).add("|\n");
+    screen.add("|  Balance: PKR ").pad(user->balance, 30).add("|\n");
+    if (user->isLocked) {
+        screen.add("|  STATUS: LOCKED (Too many failed attempts)     |\n");
+    }
+    screen.add("+-------------------------------------------------+\n");
+}
+
+void WalletConsole::displayTransactionHistory(User* user) {
+    int total = user->transactions.getCount();
+    if (total == 0) {
+        pending.add("\nNo transactions found.\n");
+        return;
+    }
+    ScreenBuffer screen;
+    screen.add(HISTORY_HEADER);
+    for (int i = 0; i < total; i++) {
+        addHistoryRow(screen, user, i);
+    }
+    screen.add(HISTORY_FOOTER);
+    show(screen);
+}
+
+void WalletConsole::displayTransactionRows(User* user, const int* rows, int n) {
+    ScreenBuffer screen;
+    addTransactionRows(screen, user, rows, n);
+    show(screen);
+}
+
+void WalletConsole::addTransactionRows(ScreenBuffer& screen, User* user, const int* rows, int n) {
+    if (n == 0) {
+        screen.add("\nNo transactions found.\n");
+        return;
+    }
+    screen.add(HISTORY_HEADER);
+    for (int i = 0; i < n; i++) {
+        addHistoryRow(screen, user, rows[i]);
+    }
+    screen.add(HISTORY_FOOTER);
+}
+
+void WalletConsole::addHistoryRow(ScreenBuffer& screen, User* user, int i) {
+    const TransactionHistory& history = user->transactions;
+    time_t ts = static_cast<time_t>(history.timestamps[i]);
+    struct tm local;
+    char date[32];
+    size_t dateLength = strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime_r(&ts, &local));
+    char idBuf[TransactionHistory::ID_TEXT_SIZE];
+    const char* id;
+    size_t idLength = history.idChars(i, idBuf, id);
+    screen.add("| ").pad(id, idLength, 12).add(" | ").pad(history.typeAt(i), 15)
+          .add(" | PKR ").pad(history.amounts[i], 12)
+          .add(" | Bal: PKR ").pad(history.balances[i], 12)
+          .add(" | ").pad(date, dateLength, 19).add(" |\n");
+    if (history.hasOtherAccount(i)) {
+        screen.add("|   -> Other Account: ").pad(history.otherAccountData(i), history.otherAccountLength(i), 73).add(" |\n");
+    }
+}
+
@@ -0,0 +1,166 @@
+// Console front end of the Smart Wallet: the menus, prompts and screens.
+// Everything here goes through the BankingSystem API; the core itself
+// never reads from cin or writes to cout.
+#ifndef SMART_WALLET_CONSOLE_H
+#define SMART_WALLET_CONSOLE_H
+
+#include "wallet.h"
+#include <iosfwd>
+
+// One screen of console output. Screens are built here and written with a
+// single write instead of a flush per endl, and pad() fills columns from
+// a constant run of spaces rather than through padString temporaries.
+class ScreenBuffer {
+public:
+    std::string text;
+
+    ScreenBuffer() {
+        text.reserve(4096);
+    }
+
+    ScreenBuffer& add(const char* s) {
+        text.append(s);
+        return *this;
+    }
+    ScreenBuffer& add(const std::string& s) {
+        text.append(s);
+        return *this;
+    }
+    ScreenBuffer& add(long long value);
+    ScreenBuffer& add(Money amount) {
+        char buf[Money::FORMATTED_SIZE];
+        text.append(buf, amount.formatTo(buf));
+        return *this;
+    }
+
+    // Appends exactly width characters: s cut short or filled with spaces.
+    ScreenBuffer& pad(const char* s, size_t length, int width);
+    ScreenBuffer& pad(const std::string& s, int width) {
+        return pad(s.data(), s.length(), width);
+    }
+    ScreenBuffer& pad(Money amount, int width) {
+        char buf[Money::FORMATTED_SIZE];
+        return pad(buf, amount.formatTo(buf), width);
+    }
+
+    // Writes the screen to out in one piece, flushes out and empties the
+    // buffer.
+    void flush(std::ostream& out);
+};
+
+// Stream buffer that hands whatever it is given straight to a file
+// descriptor, so a screen flushed through it is one write(2) however long
+// it is; a line-buffered stdio stream would split it at every newline.
+class FdOutputBuffer : public std::streambuf {
+public:
+    explicit FdOutputBuffer(int descriptor) : fd(descriptor) {}
+
+protected:
+    int overflow(int c);
+    std::streamsize xsputn(const char* s, std::streamsize n);
+
+private:
+    int fd;
+};
+
+// Standard output as a stream over an FdOutputBuffer: where the console
+// writes when it is given no stream of its own.
+std::ostream& consoleOutput();
+
+// Notice handler for console builds: prints each notice on its own line
+// to noticeStream(), which is cout unless a console is running, in which
+// case it is that console's screens.
+void printNotice(const std::string& message);
+std::ostream*& noticeStream();
+
+class WalletConsole {
+public:
+    BankingSystem& bank;
+    // Where every screen, prompt and message goes: standard output, or any
+    // other stream when the console is redirected or driven by a test.
+    std::ostream& screens;
+    // Prompts and messages since the last screen went out. They are
+    // written together with the next screen, or on their own just before
+    // the console waits for input.
+    ScreenBuffer pending;
+
+    explicit WalletConsole(BankingSystem& system);
+    WalletConsole(BankingSystem& system, std::ostream& screenStream) : bank(system), screens(screenStream) {}
+
+    // Writes anything pending followed by screen, in one write.
+    void show(ScreenBuffer& screen);
+
+    // Runs the menus until the user chooses to exit.
+    void run();
+
+    // Reads an amount typed in rupees; false if the input was not a number.
+    bool readAmount(Money& amount);
+
+    static std::string formatBalance(Money amount) {
+        return amount.format();
+    }
+
+    static std::string padString(std::string text, int width);
+
+    void printReceipt(unsigned short type, Money amount, Money balanceAfter, const std::string &otherAccount = "");
+
+    static void addBanner(ScreenBuffer& screen);
+
+    bool verifyTransactionPIN(User* user);
+
+    bool verifyPassword(User* user, const std::string& purpose = "login");
+
+    void addMainMenu(ScreenBuffer& screen);
+
+    void addDashboard(ScreenBuffer& screen, User* user);
+
+    void createAccount();
+
+    User* login();
+
+    void depositMoney(User* user);
+
+    void withdrawMoney(User* user);
+
+    void transferFunds(User* user);
+
+    // Reads a YYYY-MM-DD date as local midnight, matching how history
+    // timestamps are displayed.
+    bool readDate(const std::string& prompt, long long& when);
+
+    void viewTransactionHistory(User* user);
+
+    // Shows a date range one page at a time, leaving out its first skip
+    // transactions; each page is fetched from the timestamp index rather
+    // than by walking the whole history. Starts on the last page when
+    // latestFirst is set.
+    void viewHistoryPages(User* user, long long from, long long to, int skip = 0, bool latestFirst = false);
+
+    void undoLastTransaction(User* user);
+
+    void schedulePayment(User* user);
+
+    void cancelScheduledPayment(User* user);
+
+    void updateProfile(User* user);
+
+    void viewScheduledPayments(User* user);
+
+    void showUndoableTransactions(User* user);
+
+    void displayAccountInfo(User* user);
+
+    void addMiniInfo(ScreenBuffer& screen, User* user);
+
+    // The whole history as one screen; the menus page it instead.
+    void displayTransactionHistory(User* user);
+
+    // Shows the given rows of the history, e.g. one page of a query.
+    void displayTransactionRows(User* user, const int* rows, int n);
+
+    void addTransactionRows(ScreenBuffer& screen, User* user, const int* rows, int n);
+
+    void addHistoryRow(ScreenBuffer& screen, User* user, int i);
+};
+
+#endif
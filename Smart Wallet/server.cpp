@@ -0,0 +1,570 @@
+// Wallet server and its load generator.
+//
+// Usage:
+//   wallet_server [--durability <mode>] [--metrics <address>] serve <address>
+//   wallet_server load <address> <connections> <requests> <pipeline depth> <user ID> <password> <PIN>
+//
+// Addresses are unix:<path> or tcp:<port> (loopback only).
+#include "service.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace std;
+
+static volatile sig_atomic_t walletServerStopping = 0;
+
+static void stopWalletServer(int) {
+    walletServerStopping = 1;
+}
+
+// Serves the wallet from one epoll loop. Each request is one line of
+// whitespace-separated words; each response is one line of tab-separated
+// fields, escaped as in the journal:
+//   LOGIN <user ID> <password>                    OK <account number>
+//   BALANCE                                       OK <balance>
+//   DEPOSIT <amount> <PIN>                        OK <new balance>
+//   WITHDRAW <amount> <PIN>                       OK <new balance>
+//   TRANSFER <account> <amount> <PIN>             OK <new balance>
+//   UNDO <count> <PIN>                            OK <new balance>
+//   HISTORY [n]                                   OK <k> then 6 fields per record
+//   SCHEDULE <account> <amount> <seconds> <PIN> [password]
+//                                                 OK <payment ID>
+//   REPEAT <account> <amount> <seconds> <every seconds> <count, 0 = no limit> <PIN> [password]
+//                                                 OK <payment ID>
+//   PAYMENTS                                      OK <k> then 4 fields per payment
+//   CANCEL <payment ID>                           OK
+//   LOGOUT                                        OK
+// Failures are "ERR <reason>". Clients may pipeline: every complete line
+// received is answered in order. Changes made in one loop iteration are
+// committed together before any response is written, so an acknowledged
+// change is durable.
+class WalletServer {
+public:
+    static const int MAX_EVENTS = 256;
+    static const size_t MAX_REQUEST_BYTES = 4096;
+
+    struct Connection {
+        int fd;
+        string input;
+        string output;
+        size_t written;
+        User* user;
+        // The client has finished sending: what it sent is answered and
+        // the connection closed once the replies are written.
+        bool closing;
+        Connection(int f) : fd(f), written(0), user(nullptr), closing(false) {}
+    };
+
+    BankingSystem& bank;
+    int listenFd;
+    int epollFd;
+    Connection** connections;
+    int connectionCapacity;
+    int connectionCount;
+
+    explicit WalletServer(BankingSystem& b) : bank(b), listenFd(-1), epollFd(-1), connections(nullptr), connectionCapacity(0), connectionCount(0) {}
+    ~WalletServer() {
+        for (int fd = 0; fd < connectionCapacity; fd++) {
+            if (connections[fd] != nullptr) closeConnection(fd);
+        }
+        delete[] connections;
+        if (listenFd != -1) ::close(listenFd);
+        if (epollFd != -1) ::close(epollFd);
+    }
+
+    bool start(const string& address) {
+        raiseFileLimit();
+        listenFd = openWalletSocket(address, true);
+        if (listenFd == -1) {
+            cout << "Cannot listen on " << address << endl;
+            return false;
+        }
+        epollFd = ::epoll_create1(0);
+        if (epollFd == -1) return false;
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        return ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == 0;
+    }
+
+    // Runs until SIGINT or SIGTERM. Requests are handled under the bank's
+    // state lock, so the scheduler thread can run due payments between
+    // iterations.
+    void run() {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stopWalletServer;
+        ::sigaction(SIGINT, &action, nullptr);
+        ::sigaction(SIGTERM, &action, nullptr);
+        ::signal(SIGPIPE, SIG_IGN);
+        struct epoll_event events[MAX_EVENTS];
+        while (!walletServerStopping) {
+            int ready = ::epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+            if (ready < 0 && errno != EINTR) break;
+            lock_guard<mutex> hold(bank.stateLock);
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptClients();
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    readRequests(fd);
+                }
+            }
+            bank.commit();
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd != listenFd && fd < connectionCapacity && connections[fd] != nullptr) {
+                    flush(fd);
+                }
+            }
+        }
+        cout << "Server stopping." << endl;
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd == -1) return;
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (fd >= connectionCapacity) {
+                int newCapacity = connectionCapacity == 0 ? 1024 : connectionCapacity;
+                while (newCapacity <= fd) newCapacity *= 2;
+                Connection** grown = new Connection*[newCapacity];
+                for (int i = 0; i < newCapacity; i++) {
+                    grown[i] = i < connectionCapacity ? connections[i] : nullptr;
+                }
+                delete[] connections;
+                connections = grown;
+                connectionCapacity = newCapacity;
+            }
+            connections[fd] = new Connection(fd);
+            connectionCount++;
+            struct epoll_event event;
+            memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    void closeConnection(int fd) {
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        delete connections[fd];
+        connections[fd] = nullptr;
+        connectionCount--;
+    }
+
+    // Reads whatever has arrived and answers every complete line in it,
+    // including those that came just before the client closed its side.
+    void readRequests(int fd) {
+        Connection* connection = connections[fd];
+        if (connection->closing) return;
+        char buffer[16384];
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                connection->input.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0) {
+                connection->closing = true;
+                break;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                closeConnection(fd);
+                return;
+            }
+            if (errno != EINTR) break;
+        }
+        size_t start = 0;
+        while (true) {
+            size_t newline = connection->input.find('\n', start);
+            if (newline == string::npos) break;
+            size_t end = newline > start && connection->input[newline - 1] == '\r' ? newline - 1 : newline;
+            handleRequest(*connection, connection->input.substr(start, end - start));
+            start = newline + 1;
+        }
+        connection->input.erase(0, start);
+        if (connection->closing) {
+            connection->input.clear();
+        } else if (connection->input.length() > MAX_REQUEST_BYTES) {
+            closeConnection(fd);
+        }
+    }
+
+    void flush(int fd) {
+        Connection* connection = connections[fd];
+        while (connection->written < connection->output.length()) {
+            ssize_t n = ::write(fd, connection->output.data() + connection->written, connection->output.length() - connection->written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    closeConnection(fd);
+                    return;
+                }
+                break;
+            }
+            connection->written += static_cast<size_t>(n);
+        }
+        bool drained = connection->written == connection->output.length();
+        if (drained) {
+            if (connection->closing) {
+                closeConnection(fd);
+                return;
+            }
+            connection->output.clear();
+            connection->written = 0;
+        }
+        // A closing connection stays readable at end of file, so it only
+        // waits for room to write the rest of its replies.
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = connection->closing ? EPOLLOUT : drained ? EPOLLIN : EPOLLIN | EPOLLOUT;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    static void field(string& out, const string& value) {
+        out += '\t';
+        out += Journal::escape(value);
+    }
+
+    static void reply(Connection& connection, OperationStatus status, const string& value = "") {
+        if (status != OP_OK) {
+            connection.output += "ERR";
+            field(connection.output, operationStatusText(status));
+        } else {
+            connection.output += "OK";
+            if (!value.empty()) field(connection.output, value);
+        }
+        connection.output += '\n';
+    }
+
+    static void replyError(Connection& connection, const char* reason) {
+        connection.output += "ERR";
+        field(connection.output, reason);
+        connection.output += '\n';
+    }
+
+    void handleRequest(Connection& connection, const string& line) {
+        string words[8];
+        int n = 0;
+        size_t pos = 0;
+        while (n < 8) {
+            pos = line.find_first_not_of(" \t", pos);
+            if (pos == string::npos) break;
+            size_t end = line.find_first_of(" \t", pos);
+            words[n++] = line.substr(pos, end == string::npos ? string::npos : end - pos);
+            pos = end;
+        }
+        if (n == 0) {
+            replyError(connection, "empty request");
+            return;
+        }
+        const string& command = words[0];
+        if (command == "LOGIN" && n == 3) {
+            User* user = nullptr;
+            OperationStatus status = bank.authenticate(words[1], words[2], user);
+            if (status == OP_OK) connection.user = user;
+            reply(connection, status, status == OP_OK ? user->accountNumber : "");
+            return;
+        }
+        User* user = connection.user;
+        if (user == nullptr) {
+            replyError(connection, "not logged in");
+            return;
+        }
+        Money amount;
+        if (command == "BALANCE" && n == 1) {
+            reply(connection, OP_OK, user->balance.format());
+        } else if (command == "DEPOSIT" && n == 3) {
+            if (!Money::parse(words[1].c_str(), amount)) {
+                reply(connection, OP_INVALID_AMOUNT);
+                return;
+            }
+            OperationStatus status = bank.checkPIN(user, words[2]);
+            if (status == OP_OK) status = bank.applyDeposit(user, amount);
+            reply(connection, status, user->balance.format());
+        } else if (command == "WITHDRAW" && n == 3) {
+            if (!Money::parse(words[1].c_str(), amount)) {
+                reply(connection, OP_INVALID_AMOUNT);
+                return;
+            }
+            OperationStatus status = bank.checkPIN(user, words[2]);
+            if (status == OP_OK) status = bank.applyWithdrawal(user, amount);
+            reply(connection, status, user->balance.format());
+        } else if (command == "TRANSFER" && n == 4) {
+            int to = bank.findUserByAccountNumber(words[1]);
+            if (to == -1) {
+                reply(connection, OP_UNKNOWN_ACCOUNT);
+                return;
+            }
+            if (!Money::parse(words[2].c_str(), amount)) {
+                reply(connection, OP_INVALID_AMOUNT);
+                return;
+            }
+            OperationStatus status = bank.checkPIN(user, words[3]);
+            if (status == OP_OK) status = bank.applyTransfer(user, bank.users[to], amount);
+            reply(connection, status, user->balance.format());
+        } else if (command == "UNDO" && n == 3) {
+            OperationStatus status = bank.checkPIN(user, words[2]);
+            if (status == OP_OK) status = bank.undoLast(user, atoi(words[1].c_str()));
+            reply(connection, status, user->balance.format());
+        } else if (command == "HISTORY" && n <= 2) {
+            int wanted = n == 2 ? atoi(words[1].c_str()) : user->transactions.getCount();
+            if (wanted < 0) wanted = 0;
+            if (wanted > user->transactions.getCount()) wanted = user->transactions.getCount();
+            const TransactionHistory& history = user->transactions;
+            string& out = connection.output;
+            out += "OK";
+            field(out, to_string(wanted));
+            for (int row = history.getCount() - wanted; row < history.getCount(); row++) {
+                field(out, history.idAt(row));
+                field(out, history.typeAt(row));
+                field(out, history.amounts[row].format());
+                field(out, history.balances[row].format());
+                field(out, history.otherAccountAt(row));
+                field(out, to_string(history.timestamps[row]));
+            }
+            out += '\n';
+        } else if ((command == "SCHEDULE" && (n == 5 || n == 6)) || (command == "REPEAT" && (n == 7 || n == 8))) {
+            bool repeating = command == "REPEAT";
+            long long seconds = atoll(words[3].c_str());
+            long long every = repeating ? atoll(words[4].c_str()) : 0;
+            int maxRuns = repeating ? atoi(words[5].c_str()) : 0;
+            int pinWord = repeating ? 6 : 4;
+            if (!Money::parse(words[2].c_str(), amount)) {
+                reply(connection, OP_INVALID_AMOUNT);
+                return;
+            }
+            if (seconds < 0 || (repeating && (every <= 0 || every > 0x7fffffff || maxRuns < 0))) {
+                reply(connection, OP_INVALID_SCHEDULE);
+                return;
+            }
+            OperationStatus status = bank.checkPIN(user, words[pinWord]);
+            if (status == OP_OK && amount > Money(500000) && (n != pinWord + 2 || !user->verifyPassword(words[pinWord + 1]))) {
+                status = OP_BAD_CREDENTIALS;
+            }
+            string paymentID;
+            if (status == OP_OK) {
+                status = bank.applySchedule(user, words[1], amount, static_cast<long>(time(nullptr) + seconds), paymentID,
+                                            repeating ? PaymentPriorityQueue::RECUR_SECONDS : PaymentPriorityQueue::RECUR_NONE,
+                                            static_cast<int>(every), maxRuns);
+            }
+            reply(connection, status, paymentID);
+        } else if (command == "PAYMENTS" && n == 1) {
+            int total = bank.scheduledPayments.size();
+            PaymentPriorityQueue::PQNode** own = new PaymentPriorityQueue::PQNode*[total + 1];
+            int count = 0;
+            for (int i = 0; i < total; i++) {
+                if (bank.scheduledPayments.at(i)->fromAccount == user->accountNumber) {
+                    own[count++] = bank.scheduledPayments.at(i);
+                }
+            }
+            PaymentPriorityQueue::sortByExecution(own, count);
+            string& out = connection.output;
+            out += "OK";
+            field(out, to_string(count));
+            for (int i = 0; i < count; i++) {
+                field(out, own[i]->id);
+                field(out, own[i]->toAccount);
+                field(out, own[i]->amount.format());
+                field(out, to_string(own[i]->executeAt));
+            }
+            out += '\n';
+            delete[] own;
+        } else if (command == "CANCEL" && n == 2) {
+            reply(connection, bank.applyCancel(user, words[1]));
+        } else if (command == "LOGOUT" && n == 1) {
+            user->addSecurityLog("LOGOUT");
+            connection.user = nullptr;
+            reply(connection, OP_OK);
+        } else {
+            replyError(connection, "unknown request");
+        }
+    }
+
+private:
+    WalletServer(const WalletServer&);
+    WalletServer& operator=(const WalletServer&);
+};
+
+// Load generator for the server: opens the given number of connections,
+// logs each in, then keeps up to depth requests in flight per connection
+// (a mix of BALANCE, DEPOSIT, WITHDRAW and HISTORY) until every connection
+// has had its share answered. Reports throughput and latency percentiles,
+// measured from a request's write to its response line.
+int runLoadGenerator(const string& address, int clients, long long requests, int depth,
+                     const string& userID, const string& password, const string& pin) {
+    if (clients < 1 || requests < 1 || depth < 1) {
+        cout << "Usage: load <address> <connections> <requests> <pipeline depth> <user ID> <password> <PIN>" << endl;
+        return 1;
+    }
+    raiseFileLimit();
+    ::signal(SIGPIPE, SIG_IGN);
+    struct Client {
+        int fd;
+        string input;
+        string output;
+        long long sent;
+        long long answered;
+        long long quota;
+        long long* sentAt;
+        int head;
+        int inFlight;
+        bool loggedIn;
+    };
+    Client* connections = new Client[clients];
+    for (int c = 0; c < clients; c++) {
+        connections[c].fd = -1;
+        connections[c].sentAt = nullptr;
+    }
+    long long* latencies = new long long[requests];
+    long long measured = 0;
+    long long failures = 0;
+    // Set on a failure that ends the run early; everything is still
+    // released through the one path at the end.
+    bool aborted = false;
+    int epollFd = ::epoll_create1(0);
+    const string requestsMix[] = {"BALANCE", "DEPOSIT 1.00 " + pin, "WITHDRAW 1.00 " + pin, "HISTORY 5"};
+    for (int c = 0; c < clients && !aborted; c++) {
+        Client& client = connections[c];
+        client.fd = openWalletSocket(address, false);
+        if (client.fd == -1) {
+            cout << "Cannot connect to " << address << " (connection " << c + 1 << ")" << endl;
+            aborted = true;
+            break;
+        }
+        client.sent = 0;
+        client.answered = 0;
+        client.quota = requests / clients + (c < requests % clients ? 1 : 0);
+        client.sentAt = new long long[depth + 1];
+        client.head = 0;
+        client.inFlight = 0;
+        client.loggedIn = false;
+        client.output = "LOGIN " + userID + " " + password + "\n";
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u32 = static_cast<unsigned>(c);
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    }
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    int finished = aborted ? clients : 0;
+    struct epoll_event events[256];
+    char buffer[65536];
+    while (finished < clients) {
+        int ready = ::epoll_wait(epollFd, events, 256, 5000);
+        if (ready <= 0) {
+            cout << "Server stopped answering." << endl;
+            break;
+        }
+        for (int e = 0; e < ready; e++) {
+            Client& client = connections[events[e].data.u32];
+            if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                ssize_t n = ::read(client.fd, buffer, sizeof(buffer));
+                if (n <= 0 && !(n < 0 && (errno == EAGAIN || errno == EINTR))) {
+                    cout << "Connection closed by server." << endl;
+                    finished = clients;
+                    break;
+                }
+                if (n > 0) client.input.append(buffer, static_cast<size_t>(n));
+                long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+                size_t start = 0;
+                size_t newline;
+                while ((newline = client.input.find('\n', start)) != string::npos) {
+                    bool ok = client.input.compare(start, 2, "OK") == 0;
+                    start = newline + 1;
+                    if (!client.loggedIn) {
+                        if (!ok) {
+                            cout << "Login failed for " << userID << endl;
+                            aborted = true;
+                            finished = clients;
+                            break;
+                        }
+                        client.loggedIn = true;
+                        continue;
+                    }
+                    if (!ok) failures++;
+                    latencies[measured++] = now - client.sentAt[client.head];
+                    client.head = (client.head + 1) % (depth + 1);
+                    client.inFlight--;
+                    client.answered++;
+                    if (client.answered == client.quota) finished++;
+                }
+                client.input.erase(0, start);
+                if (aborted) break;
+            }
+            if (client.loggedIn) {
+                long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+                while (client.inFlight < depth && client.sent < client.quota) {
+                    client.output += requestsMix[client.sent % 4];
+                    client.output += '\n';
+                    client.sentAt[(client.head + client.inFlight) % (depth + 1)] = now;
+                    client.inFlight++;
+                    client.sent++;
+                }
+            }
+            while (!client.output.empty()) {
+                ssize_t n = ::write(client.fd, client.output.data(), client.output.length());
+                if (n <= 0) break;
+                client.output.erase(0, static_cast<size_t>(n));
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    sort(latencies, latencies + measured);
+    if (!aborted) {
+        cout << "Load: " << clients << " connection(s), pipeline depth " << depth << ", "
+             << measured << " request(s) in " << seconds << " s, " << failures << " error response(s)" << endl;
+    }
+    if (!aborted && measured > 0) {
+        cout << "Throughput: " << static_cast<long long>(measured / seconds) << " requests/sec" << endl;
+        cout << "Latency us: p50 " << latencies[measured / 2] / 1000.0
+             << ", p99 " << latencies[measured * 99 / 100] / 1000.0
+             << ", p99.9 " << latencies[measured * 999 / 1000] / 1000.0
+             << ", max " << latencies[measured - 1] / 1000.0 << endl;
+    }
+    for (int c = 0; c < clients; c++) {
+        if (connections[c].fd != -1) ::close(connections[c].fd);
+        delete[] connections[c].sentAt;
+    }
+    delete[] connections;
+    delete[] latencies;
+    if (epollFd != -1) ::close(epollFd);
+    return !aborted && measured == requests && failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    WalletOptions options;
+    if (!options.parse(argc, argv)) return 1;
+    noticeHandler() = printToolNotice;
+    if (argc == 3 && string(argv[1]) == "serve") {
+        srand(static_cast<unsigned int>(time(0)));
+        BankingSystem bankSystem;
+        WalletServer server(bankSystem);
+        if (!server.start(argv[2])) return 1;
+        cout << "Serving on " << argv[2] << endl;
+        bankSystem.startScheduler();
+        server.run();
+        return 0;
+    }
+    if (argc == 9 && string(argv[1]) == "load") {
+        return runLoadGenerator(argv[2], atoi(argv[3]), atoll(argv[4]), atoi(argv[5]), argv[6], argv[7], argv[8]);
+    }
+    cout << "Usage:" << endl;
+    cout << "  wallet_server [--durability <mode>] [--metrics <address>] serve <address>" << endl;
+    cout << "  wallet_server load <address> <connections> <requests> <pipeline depth> <user ID> <password> <PIN>" << endl;
+    return 1;
+}
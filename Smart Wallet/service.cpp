@@ -0,0 +1,221 @@
+#include "service.h"
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace std;
+
+int openWalletSocket(const string& address, bool listen) {
+    int fd = -1;
+    if (address.compare(0, 5, "unix:") == 0) {
+        string path = address.substr(5);
+        struct sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        if (path.empty() || path.length() >= sizeof(local.sun_path)) return -1;
+        memcpy(local.sun_path, path.c_str(), path.length());
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) return -1;
+        if (listen) {
+            ::unlink(path.c_str());
+            if (::bind(fd, reinterpret_cast<struct sockaddr*>(&local), sizeof(local)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+        } else if (::connect(fd, reinterpret_cast<struct sockaddr*>(&local), sizeof(local)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    } else if (address.compare(0, 4, "tcp:") == 0) {
+        int port = atoi(address.c_str() + 4);
+        if (port <= 0 || port > 65535) return -1;
+        struct sockaddr_in loopback;
+        memset(&loopback, 0, sizeof(loopback));
+        loopback.sin_family = AF_INET;
+        loopback.sin_port = htons(static_cast<unsigned short>(port));
+        loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) return -1;
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (listen) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (::bind(fd, reinterpret_cast<struct sockaddr*>(&loopback), sizeof(loopback)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+        } else if (::connect(fd, reinterpret_cast<struct sockaddr*>(&loopback), sizeof(loopback)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    if (listen && ::listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+void printToolNotice(const string& message) {
+    cout << message << endl;
+}
+
+void raiseFileLimit() {
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+#ifndef SMART_WALLET_NO_METRICS
+static volatile sig_atomic_t metricsSignalFd = -1;
+
+static void requestMetricsDump(int) {
+    int saved = errno;
+    char wake = 'd';
+    if (metricsSignalFd != -1) {
+        ssize_t ignored = ::write(metricsSignalFd, &wake, 1);
+        (void)ignored;
+    }
+    errno = saved;
+}
+
+bool MetricsExporter::start(const string& address) {
+    if (worker.joinable() || ::pipe(wakePipe) != 0) return false;
+    if (address.compare(0, 5, "file:") == 0 && address.length() > 5) {
+        filePath = address.substr(5);
+        metricsSignalFd = wakePipe[1];
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = requestMetricsDump;
+        action.sa_flags = SA_RESTART;
+        ::sigaction(SIGUSR1, &action, nullptr);
+    } else {
+        listenFd = openWalletSocket(address, true);
+        if (listenFd == -1) {
+            closePipe();
+            return false;
+        }
+        ::signal(SIGPIPE, SIG_IGN);
+    }
+    worker = thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!worker.joinable()) return;
+    char wake = 's';
+    if (::write(wakePipe[1], &wake, 1) == 1) worker.join();
+    else worker.detach();
+    if (!filePath.empty()) {
+        ::signal(SIGUSR1, SIG_IGN);
+        metricsSignalFd = -1;
+        writeFile();
+    }
+    if (listenFd != -1) ::close(listenFd);
+    listenFd = -1;
+    closePipe();
+}
+
+void MetricsExporter::closePipe() {
+    for (int i = 0; i < 2; i++) {
+        if (wakePipe[i] != -1) ::close(wakePipe[i]);
+        wakePipe[i] = -1;
+    }
+}
+
+void MetricsExporter::run() {
+    struct pollfd watched[2];
+    watched[0].fd = wakePipe[0];
+    watched[0].events = POLLIN;
+    watched[1].fd = listenFd;
+    watched[1].events = POLLIN;
+    int count = listenFd == -1 ? 1 : 2;
+    while (true) {
+        if (::poll(watched, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (watched[0].revents & POLLIN) {
+            char wake = 's';
+            if (::read(wakePipe[0], &wake, 1) != 1 || wake == 's') return;
+            writeFile();
+        }
+        if (count == 2 && (watched[1].revents & POLLIN)) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd != -1) serve(fd);
+        }
+    }
+}
+
+void MetricsExporter::serve(int fd) {
+    struct pollfd request;
+    request.fd = fd;
+    request.events = POLLIN;
+    if (::poll(&request, 1, REQUEST_WAIT_MS) > 0) {
+        char discard[4096];
+        if (::read(fd, discard, sizeof(discard)) < 0) {
+            ::close(fd);
+            return;
+        }
+    }
+    string body = Metrics::instance().dump();
+    string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                      to_string(body.length()) + "\r\n\r\n" + body;
+    size_t written = 0;
+    while (written < response.length()) {
+        ssize_t n = ::write(fd, response.data() + written, response.length() - written);
+        if (n <= 0) break;
+        written += static_cast<size_t>(n);
+    }
+    ::close(fd);
+}
+
+bool MetricsExporter::writeFile() {
+    string temporary = filePath + ".tmp";
+    {
+        ofstream out(temporary.c_str(), ios::trunc);
+        out << Metrics::instance().dump();
+        if (!out) return false;
+    }
+    return ::rename(temporary.c_str(), filePath.c_str()) == 0;
+}
+#endif
+
+bool WalletOptions::parse(int& argc, char**& argv) {
+    while (argc >= 3) {
+        string option = argv[1];
+        if (option == "--durability") {
+            if (!DurabilityConfig::current().parse(argv[2])) {
+                cout << "Usage: --durability <sync|group|async>[:<window ms>] ..." << endl;
+                return false;
+            }
+        } else if (option == "--metrics") {
+#ifndef SMART_WALLET_NO_METRICS
+            if (!metricsExporter.start(argv[2])) {
+                cout << "Cannot publish metrics on " << argv[2] << endl;
+                return false;
+            }
+#else
+            cout << "This build has no metrics (SMART_WALLET_NO_METRICS)." << endl;
+            return false;
+#endif
+        } else {
+            break;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+// Process plumbing shared by the wallet executables: wallet sockets, the
+// metrics exporter and the options that may precede any mode.
+#ifndef SMART_WALLET_SERVICE_H
+#define SMART_WALLET_SERVICE_H
+
+#include "wallet.h"
+
+// Opens a listening (listen = true) or connected socket for a wallet
+// address: "unix:<path>" for a Unix domain socket or "tcp:<port>" for
+// loopback TCP. Returns -1 on failure.
+int openWalletSocket(const std::string& address, bool listen);
+
+// Notice handler for the servers and tools: prints each notice on its own
+// line.
+void printToolNotice(const std::string& message);
+
+// Raises the open-file limit as far as allowed so one process can hold
+// thousands of connections.
+void raiseFileLimit();
+
+#ifndef SMART_WALLET_NO_METRICS
+// Publishes Metrics::dump() from a thread of its own. With unix:<path> or
+// tcp:<port> every connection gets the current metrics as a small HTTP
+// response, so Prometheus or curl can scrape them. With file:<path> they
+// are written to the file (via a temporary and a rename) on SIGUSR1 and
+// once more when the exporter stops.
+class MetricsExporter {
+public:
+    static const int REQUEST_WAIT_MS = 200;
+    int listenFd;
+    int wakePipe[2];
+    std::string filePath;
+    std::thread worker;
+
+    MetricsExporter() : listenFd(-1) {
+        wakePipe[0] = -1;
+        wakePipe[1] = -1;
+    }
+    ~MetricsExporter() {
+        stop();
+    }
+
+    bool start(const std::string& address);
+    void stop();
+    void closePipe();
+    void run();
+
+    // Answers whatever request arrives within REQUEST_WAIT_MS with the
+    // metrics; a client that sends nothing still gets them.
+    void serve(int fd);
+
+    bool writeFile();
+
+private:
+    MetricsExporter(const MetricsExporter&);
+    MetricsExporter& operator=(const MetricsExporter&);
+};
+#endif
+
+// The options every executable accepts ahead of its mode:
+//   --durability sync|group|async[:<window ms>]
+//   --metrics unix:<path>|tcp:<port>|file:<path>
+// The metrics exporter lives as long as this object.
+class WalletOptions {
+public:
+#ifndef SMART_WALLET_NO_METRICS
+    MetricsExporter metricsExporter;
+#endif
+
+    // Applies the leading options and moves argc/argv past them. Prints
+    // what was wrong and returns false on a bad value.
+    bool parse(int& argc, char**& argv);
+};
+
+#endif
@@ -0,0 +1,321 @@
+// Self-checks for the wallet core, registered with CTest. Each check
+// prints what it measured and exits non-zero on failure.
+//
+// Usage:
+//   wallet_tests stress-ids <threads> <IDs per thread>
+//   wallet_tests stress-transfers <accounts> <transfers> [max threads]
+//   wallet_tests [--durability <mode>] stress-commits <work dir> <accounts> <transfers> <threads>
+//   wallet_tests check-checkpoint <work dir>
+//
+// The checks that save data do so only inside the work directory given,
+// which they create and clear of earlier bank_data files.
+#include "service.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <sys/stat.h>
+#include <dirent.h>
+
+using namespace std;
+
+// Creates workDirectory if needed, makes it the working directory and
+// removes any data files an earlier run left there.
+bool enterWorkDirectory(const string& workDirectory) {
+    if (::mkdir(workDirectory.c_str(), 0700) != 0 && errno != EEXIST) {
+        cout << "Cannot create " << workDirectory << endl;
+        return false;
+    }
+    if (::chdir(workDirectory.c_str()) != 0) return false;
+    DIR* listing = ::opendir(".");
+    while (dirent* entry = listing == nullptr ? nullptr : ::readdir(listing)) {
+        string name = entry->d_name;
+        if (name.compare(0, 9, "bank_data") == 0) ::unlink(name.c_str());
+    }
+    if (listing != nullptr) ::closedir(listing);
+    return true;
+}
+
+// One thread of the transfer stress run: random transfers between random
+// accounts, with a private generator so threads never share state outside
+// the bank itself.
+void transferWorker(BankingSystem* bank, long long transfers, unsigned long long seed, long long* applied) {
+    unsigned long long state = seed * 2654435761ULL + 1;
+    long long done = 0;
+    for (long long i = 0; i < transfers; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int from = static_cast<int>(state % static_cast<unsigned long long>(bank->userCount));
+        int to = static_cast<int>((state >> 20) % static_cast<unsigned long long>(bank->userCount));
+        Money amount((state >> 40) % 50000 + 1);
+        if (bank->transferConcurrent(from, to, amount) == OP_OK) done++;
+    }
+    *applied = done;
+}
+
+// Checks that a run moved money without creating or losing any: the bank
+// total is unchanged, and every account's history replays to its balance.
+bool transfersConserved(BankingSystem& bank, Money expectedTotal, long long applied) {
+    if (bank.totalBalance() != expectedTotal) return false;
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    long long transfersOut = 0;
+    long long transfersIn = 0;
+    for (int i = 0; i < bank.userCount; i++) {
+        TransactionHistory& history = bank.users[i]->transactions;
+        Money replayed;
+        for (int row = 0; row < history.getCount(); row++) {
+            unsigned short type = history.types[row];
+            if (table.has(type, TXF_CREDIT)) replayed += history.amounts[row];
+            if (table.has(type, TXF_DEBIT)) replayed -= history.amounts[row];
+            if (type == TXN_TRANSFER_OUT) transfersOut++;
+            if (type == TXN_TRANSFER_IN) transfersIn++;
+        }
+        if (replayed != bank.users[i]->balance) return false;
+    }
+    return transfersOut == applied && transfersIn == applied;
+}
+
+// Adds accounts numbered USER1000 upwards, each opened with 1000.00.
+void addStressAccounts(BankingSystem& bank, int accounts) {
+    for (int i = 0; i < accounts; i++) {
+        User* user = new User("Stress " + to_string(i), "USER" + to_string(1000 + i), "password", "1234",
+                              "stress" + to_string(i) + "@example.com", "03000000000", "-", "Savings", Money());
+        user->addTransactionRecord(TXN_ACCOUNT_CREATION, Money(100000), Money(100000));
+        user->journal = &bank.journal;
+        if (bank.userCount >= bank.capacity) {
+            bank.resizeArray();
+        }
+        bank.users[bank.userCount] = user;
+        bank.indexUser(bank.userCount);
+        bank.userCount++;
+    }
+}
+
+// Stress test and scaling benchmark for concurrent transfers: for 1, 2, 4,
+// ... maxThreads threads, runs the same number of random transfers over a
+// fresh in-memory bank and verifies conservation afterwards. Few accounts
+// means heavy contention on the lock stripes.
+int stressTransfers(int accounts, long long transfers, int maxThreads) {
+    if (accounts < 2 || transfers < 1 || maxThreads < 1) {
+        cout << "Usage: stress-transfers <accounts >= 2> <transfers> [max threads]" << endl;
+        return 1;
+    }
+    cout << "Concurrent transfers: " << accounts << " accounts, " << transfers << " transfers per run, "
+         << AccountLocks::STRIPES << " lock stripes, " << thread::hardware_concurrency() << " hardware threads" << endl;
+    bool allConserved = true;
+    int threads = 1;
+    while (true) {
+        BankingSystem bank(false);
+        addStressAccounts(bank, accounts);
+        Money before = bank.totalBalance();
+        long long* applied = new long long[threads];
+        thread* workers = new thread[threads];
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            long long share = transfers / threads + (t < transfers % threads ? 1 : 0);
+            workers[t] = thread(transferWorker, &bank, share, static_cast<unsigned long long>(t + 1), &applied[t]);
+        }
+        for (int t = 0; t < threads; t++) {
+            workers[t].join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        long long totalApplied = 0;
+        for (int t = 0; t < threads; t++) {
+            totalApplied += applied[t];
+        }
+        delete[] workers;
+        delete[] applied;
+        bool conserved = transfersConserved(bank, before, totalApplied);
+        allConserved = allConserved && conserved;
+        cout << "  " << threads << " thread(s): " << static_cast<long long>(transfers / seconds) << " transfers/sec, "
+             << totalApplied << " applied, money " << (conserved ? "conserved" : "NOT CONSERVED") << endl;
+        if (threads == maxThreads) break;
+        threads = threads * 2 < maxThreads ? threads * 2 : maxThreads;
+    }
+    return allConserved ? 0 : 1;
+}
+
+// One thread of the commit stress run: each transfer is committed on its
+// own, as the server would, and the time both took is recorded.
+void commitWorker(BankingSystem* bank, long long transfers, unsigned long long seed, long long* applied, long long* latencies) {
+    unsigned long long state = seed * 2654435761ULL + 1;
+    long long done = 0;
+    for (long long i = 0; i < transfers; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int from = static_cast<int>(state % static_cast<unsigned long long>(bank->userCount));
+        int to = static_cast<int>((state >> 20) % static_cast<unsigned long long>(bank->userCount));
+        Money amount((state >> 40) % 50000 + 1);
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        if (bank->transferConcurrent(from, to, amount) == OP_OK) done++;
+        bank->commit();
+        latencies[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+    }
+    *applied = done;
+}
+
+// Transfer+commit latency under the durability mode in force: threads
+// threads share transfers over a fresh bank saved in workDirectory, each
+// committing after every transfer. Money must be conserved, and the
+// reloaded bank (snapshot plus journal) must hold the same balances.
+int stressCommits(const string& workDirectory, int accounts, long long transfers, int threads) {
+    if (accounts < 2 || transfers < 1 || threads < 1) {
+        cout << "Usage: stress-commits <work directory> <accounts >= 2> <transfers> <threads>" << endl;
+        return 1;
+    }
+    if (!enterWorkDirectory(workDirectory)) return 1;
+    Money before;
+    bool conserved = false;
+    Money* balances = new Money[accounts];
+    {
+        BankingSystem bank;
+        addStressAccounts(bank, accounts);
+        if (!bank.saveToFile()) return 1;
+        before = bank.totalBalance();
+        long long* applied = new long long[threads];
+        long long* latencies = new long long[transfers];
+        thread* workers = new thread[threads];
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        long long offset = 0;
+        for (int t = 0; t < threads; t++) {
+            long long share = transfers / threads + (t < transfers % threads ? 1 : 0);
+            workers[t] = thread(commitWorker, &bank, share, static_cast<unsigned long long>(t + 1), &applied[t], latencies + offset);
+            offset += share;
+        }
+        for (int t = 0; t < threads; t++) {
+            workers[t].join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        long long totalApplied = 0;
+        for (int t = 0; t < threads; t++) {
+            totalApplied += applied[t];
+        }
+        sort(latencies, latencies + transfers);
+        conserved = transfersConserved(bank, before, totalApplied);
+        for (int i = 0; i < accounts; i++) {
+            balances[i] = bank.users[i]->balance;
+        }
+        cout << "Transfer+commit: " << accounts << " accounts, " << threads << " thread(s), "
+             << static_cast<long long>(transfers / seconds) << " op/s" << endl;
+        cout << "Latency us: p50 " << latencies[transfers / 2] / 1000.0 << ", p99 " << latencies[transfers * 99 / 100] / 1000.0
+             << ", max " << latencies[transfers - 1] / 1000.0 << endl;
+        delete[] workers;
+        delete[] latencies;
+        delete[] applied;
+    }
+    BankingSystem reloaded;
+    bool recovered = reloaded.userCount == accounts;
+    for (int i = 0; recovered && i < accounts; i++) {
+        recovered = reloaded.users[i]->balance == balances[i];
+    }
+    delete[] balances;
+    cout << "Money " << (conserved ? "conserved" : "NOT CONSERVED") << ", reload " << (recovered ? "matches" : "DIFFERS") << endl;
+    return conserved && recovered ? 0 : 1;
+}
+
+void idWorker(long long count, unsigned long long* out, bool* increasing) {
+    IDGenerator& generator = IDGenerator::instance();
+    bool ok = true;
+    for (long long i = 0; i < count; i++) {
+        out[i] = generator.next();
+        if (i > 0 && out[i] <= out[i - 1]) ok = false;
+    }
+    *increasing = ok;
+}
+
+// Draws perThread IDs on each of threads threads at once and checks that
+// every thread saw its IDs strictly increase and that no ID was issued
+// twice.
+int stressIDs(int threads, long long perThread) {
+    if (threads < 1 || perThread < 1) {
+        cout << "Usage: stress-ids <threads> <IDs per thread>" << endl;
+        return 1;
+    }
+    long long total = perThread * threads;
+    unsigned long long* issued = new unsigned long long[total];
+    bool* increasing = new bool[threads];
+    thread* workers = new thread[threads];
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = thread(idWorker, perThread, issued + perThread * t, &increasing[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    bool allIncreasing = true;
+    for (int t = 0; t < threads; t++) {
+        allIncreasing = allIncreasing && increasing[t];
+    }
+    sort(issued, issued + total);
+    long long duplicates = 0;
+    for (long long i = 1; i < total; i++) {
+        if (issued[i] == issued[i - 1]) duplicates++;
+    }
+    cout << "IDs: " << total << " from " << threads << " thread(s), " << static_cast<long long>(total / seconds) << " IDs/sec, "
+         << duplicates << " duplicate(s), " << (allIncreasing ? "increasing" : "NOT INCREASING") << " per thread" << endl;
+    delete[] workers;
+    delete[] increasing;
+    delete[] issued;
+    return duplicates == 0 && allIncreasing ? 0 : 1;
+}
+
+// Self-check for background checkpoints, run in its own work directory:
+// opens two accounts and saves, deposits into one before a background
+// checkpoint starts and into the other while it runs, collects the
+// checkpoint, saves again and reloads. Both deposits must survive.
+int checkBackgroundCheckpoint(const string& workDirectory) {
+    if (!enterWorkDirectory(workDirectory)) return 1;
+    string first, second;
+    {
+        BankingSystem bank;
+        User* a = nullptr;
+        User* b = nullptr;
+        if (bank.openAccount("Check One", "one@example.com", "03001234567", "Street 1", "Savings", Money(10000), "GoodPass9", "2580", a) != OP_OK ||
+            bank.openAccount("Check Two", "two@example.com", "03001234567", "Street 2", "Savings", Money(10000), "GoodPass9", "2580", b) != OP_OK) {
+            cout << "Cannot open the check accounts." << endl;
+            return 1;
+        }
+        first = a->accountNumber;
+        second = b->accountNumber;
+        if (!bank.saveToFile()) return 1;
+        bank.applyDeposit(a, Money(500));
+        bank.commit();
+        bank.startBackgroundCheckpoint();
+        bank.applyDeposit(b, Money(777));
+        bank.commit();
+        bank.finishBackgroundCheckpoint(true);
+        if (!bank.saveToFile()) return 1;
+    }
+    BankingSystem reloaded;
+    int a = reloaded.findUserByAccountNumber(first);
+    int b = reloaded.findUserByAccountNumber(second);
+    bool kept = a != -1 && b != -1 && reloaded.users[a]->balance == Money(10500) && reloaded.users[b]->balance == Money(10777);
+    cout << "Background checkpoint: " << (kept ? "changes made while it ran were kept" : "CHANGES LOST") << endl;
+    return kept ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    WalletOptions options;
+    if (!options.parse(argc, argv)) return 1;
+    noticeHandler() = printToolNotice;
+    if (argc == 4 && string(argv[1]) == "stress-ids") {
+        return stressIDs(atoi(argv[2]), atoll(argv[3]));
+    }
+    if ((argc == 4 || argc == 5) && string(argv[1]) == "stress-transfers") {
+        return stressTransfers(atoi(argv[2]), atoll(argv[3]), argc == 5 ? atoi(argv[4]) : 32);
+    }
+    if (argc == 6 && string(argv[1]) == "stress-commits") {
+        return stressCommits(argv[2], atoi(argv[3]), atoll(argv[4]), atoi(argv[5]));
+    }
+    if (argc == 3 && string(argv[1]) == "check-checkpoint") {
+        return checkBackgroundCheckpoint(argv[2]);
+    }
+    cout << "Usage:" << endl;
+    cout << "  wallet_tests stress-ids <threads> <IDs per thread>" << endl;
+    cout << "  wallet_tests stress-transfers <accounts> <transfers> [max threads]" << endl;
+    cout << "  wallet_tests [--durability <mode>] stress-commits <work dir> <accounts> <transfers> <threads>" << endl;
+    cout << "  wallet_tests check-checkpoint <work dir>" << endl;
+    return 1;
+}
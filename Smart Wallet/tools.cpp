@@ -0,0 +1,137 @@
+// Offline tools for wallet data files.
+//
+// Usage:
+//   wallet_tools convert <input> <output>
+//   wallet_tools compile-batch <batch.csv> <batch.bin>
+//   wallet_tools [--durability <mode>] batch <batch file>
+//
+// convert turns a text data file into a binary snapshot or back; batch
+// applies a batch file (CSV or compiled) to the bank in the working
+// directory.
+#include "service.h"
+#include <iostream>
+
+using namespace std;
+
+// Converts a data file between the text and binary formats: text input is
+// written as a binary snapshot, a binary snapshot is written back as text.
+int convertDataFile(const string& input, const string& output) {
+    BankingSystem store(false);
+    ifstream probe(input.c_str(), ios::binary);
+    if (!probe.is_open()) {
+        cout << "Cannot open " << input << endl;
+        return 1;
+    }
+    char magic[8] = {0};
+    probe.read(magic, 8);
+    probe.close();
+    bool saved;
+    if (memcmp(magic, "SWSNAPSH", 8) == 0) {
+        if (!store.loadBinaryFile(input)) {
+            cout << input << " is not a valid snapshot." << endl;
+            return 1;
+        }
+        saved = store.saveTextFile(output, store.journal.generation);
+    } else {
+        store.loadTextFile(input);
+        saved = store.saveBinaryFile(output, store.journal.generation);
+    }
+    if (!saved) {
+        cout << "Cannot write " << output << endl;
+        return 1;
+    }
+    cout << "Converted " << store.userCount << " account(s) and " << store.scheduledPayments.size()
+         << " scheduled payment(s) from " << input << " to " << output << endl;
+    return 0;
+}
+
+// Turns a CSV batch file into the binary form runBatch reads fastest.
+int compileBatchFile(const string& input, const string& output) {
+    MappedFile file;
+    if (!file.open(input)) {
+        cout << "Cannot open " << input << endl;
+        return 1;
+    }
+    SnapshotWriter out;
+    out.buffer = "SWBATCH1";
+    TextCursor in(file.data, file.size);
+    string line;
+    BatchOperation op;
+    long long lineNumber = 0;
+    long long operations = 0;
+    while (in.readLine(line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+        if (!BankingSystem::parseBatchLine(line, op)) {
+            cout << "Line " << lineNumber << " is malformed." << endl;
+            return 1;
+        }
+        out.putU8(static_cast<unsigned>(op.kind));
+        out.putString(op.fromAccount);
+        out.putString(op.toAccount);
+        out.putMoney(op.amount);
+        operations++;
+    }
+    ofstream result(output.c_str(), ios::binary | ios::trunc);
+    result.write(out.buffer.data(), static_cast<streamsize>(out.buffer.length()));
+    result.close();
+    if (result.fail()) {
+        cout << "Cannot write " << output << endl;
+        return 1;
+    }
+    cout << "Compiled " << operations << " operation(s) from " << input << " to " << output << endl;
+    return 0;
+}
+
+// Applies a batch file and prints what happened: the first few rejected
+// operations, the count per outcome and the timings.
+int runBatchFile(BankingSystem& bank, const string& fileName) {
+    BatchSummary summary;
+    bool committed = bank.runBatch(fileName, summary);
+    if (!summary.opened) {
+        cout << "Cannot open " << fileName << endl;
+        return 1;
+    }
+    for (int i = 0; i < summary.problemCount; i++) {
+        cout << "  " << summary.problems[i] << endl;
+    }
+    long long applied = summary.outcomes[OP_OK];
+    cout << "Batch " << fileName << ": " << summary.operations << " operation(s), "
+         << applied << " applied, " << summary.operations - applied << " rejected, "
+         << summary.malformed << " malformed" << endl;
+    for (int i = OP_OK + 1; i < OP_STATUS_COUNT; i++) {
+        if (summary.outcomes[i] > 0) {
+            cout << "  " << operationStatusText(static_cast<OperationStatus>(i)) << ": " << summary.outcomes[i] << endl;
+        }
+    }
+    cout << "Applied in " << summary.applySeconds * 1000 << " ms, committed in "
+         << (summary.totalSeconds - summary.applySeconds) * 1000 << " ms" << endl;
+    cout << "Throughput: " << static_cast<long long>(summary.totalSeconds > 0 ? summary.operations / summary.totalSeconds : 0)
+         << " ops/sec" << endl;
+    if (!committed) {
+        cout << "The batch could not be saved; it is applied in memory only and will be saved again on exit." << endl;
+    }
+    return committed ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    WalletOptions options;
+    if (!options.parse(argc, argv)) return 1;
+    noticeHandler() = printToolNotice;
+    if (argc == 4 && string(argv[1]) == "convert") {
+        return convertDataFile(argv[2], argv[3]);
+    }
+    if (argc == 4 && string(argv[1]) == "compile-batch") {
+        return compileBatchFile(argv[2], argv[3]);
+    }
+    if (argc == 3 && string(argv[1]) == "batch") {
+        srand(static_cast<unsigned int>(time(0)));
+        BankingSystem bankSystem;
+        return runBatchFile(bankSystem, argv[2]);
+    }
+    cout << "Usage:" << endl;
+    cout << "  wallet_tools convert <input> <output>" << endl;
+    cout << "  wallet_tools compile-batch <batch.csv> <batch.bin>" << endl;
+    cout << "  wallet_tools [--durability <mode>] batch <batch file>" << endl;
+    return 1;
+}
@@ -0,0 +1,2622 @@
+#include "wallet.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+using namespace std;
+
+void UndoRing::set(Entry& entry, unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter,
+                   const string& otherAccount, long timestamp, unsigned long long transfer) {
+    entry.id = id;
+    entry.type = type;
+    entry.amount = amount;
+    entry.balanceBefore = balanceBefore;
+    entry.balanceAfter = balanceAfter;
+    entry.otherAccount = otherAccount;
+    entry.timestamp = timestamp;
+    entry.transfer = transfer;
+}
+
+void UndoRing::push(unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter, const string& otherAccount,
+                    long timestamp, unsigned long long transfer) {
+    if (entries == nullptr) entries = new Entry[CAPACITY];
+    Entry* entry;
+    if (count == CAPACITY) {
+        entry = &entries[first];
+        first = (first + 1) % CAPACITY;
+    } else {
+        entry = &entries[(first + count) % CAPACITY];
+        count++;
+    }
+    set(*entry, id, type, amount, balanceBefore, balanceAfter, otherAccount, timestamp, transfer);
+}
+
+void UndoRing::pushOldest(unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter, const string& otherAccount,
+                          long timestamp, unsigned long long transfer) {
+    if (count == CAPACITY) return;
+    if (entries == nullptr) entries = new Entry[CAPACITY];
+    first = (first + CAPACITY - 1) % CAPACITY;
+    count++;
+    set(entries[first], id, type, amount, balanceBefore, balanceAfter, otherAccount, timestamp, transfer);
+}
+
+int UndoRing::find(unsigned long long id) const {
+    for (int i = 0; i < count; i++) {
+        if (at(i)->id == id) return i;
+    }
+    return -1;
+}
+
+int UndoRing::findTransfer(unsigned long long transfer) const {
+    if (transfer == 0) return -1;
+    for (int i = 0; i < count; i++) {
+        if (at(i)->transfer == transfer) return i;
+    }
+    return -1;
+}
+
+void UndoRing::remove(int i) {
+    if (i < 0 || i >= count) return;
+    for (; i + 1 < count; i++) {
+        swap(*at(i), *at(i + 1));
+    }
+    count--;
+}
+
+void UndoRing::dropNewest(int n) {
+    count = n >= count ? 0 : count - n;
+}
+
+void UndoRing::expire(long now) {
+    while (count > 0 && now - entries[first].timestamp > SecurityConfig::UNDO_WINDOW) {
+        first = (first + 1) % CAPACITY;
+        count--;
+    }
+}
+
+int UndoRing::live(long now) const {
+    int n = 0;
+    while (n < count && now - newest(n)->timestamp <= SecurityConfig::UNDO_WINDOW) n++;
+    return n;
+}
+
+TransactionTypeTable::TransactionTypeTable() : names(nullptr), flagBits(nullptr), reversals(nullptr), count(0), capacity(64), slots(nullptr), slotCapacity(128) {
+    names = new string[capacity];
+    flagBits = new unsigned char[capacity];
+    reversals = new unsigned short[capacity];
+    slots = new int[slotCapacity];
+    for (int i = 0; i < slotCapacity; i++) {
+        slots[i] = -1;
+    }
+    define("ACCOUNT CREATION", TXF_CREDIT, TXN_NONE);
+    define("DEPOSIT", TXF_UNDOABLE | TXF_CREDIT, TXN_UNDO_DEPOSIT);
+    define("WITHDRAW", TXF_UNDOABLE | TXF_DEBIT, TXN_UNDO_WITHDRAW);
+    define("TRANSFER OUT", TXF_UNDOABLE | TXF_DEBIT | TXF_TRANSFER, TXN_UNDO_TRANSFER_OUT);
+    define("TRANSFER IN", TXF_UNDOABLE | TXF_CREDIT | TXF_TRANSFER, TXN_UNDO_TRANSFER_IN);
+    define("SCHEDULED TRANSFER OUT", TXF_SCHEDULED | TXF_DEBIT | TXF_TRANSFER, TXN_NONE);
+    define("SCHEDULED TRANSFER IN", TXF_SCHEDULED | TXF_CREDIT | TXF_TRANSFER, TXN_NONE);
+    define("UNDO DEPOSIT", TXF_UNDO | TXF_DEBIT, TXN_NONE);
+    define("UNDO WITHDRAW", TXF_UNDO | TXF_CREDIT, TXN_NONE);
+    define("UNDO TRANSFER OUT", TXF_UNDO | TXF_CREDIT | TXF_TRANSFER, TXN_NONE);
+    define("UNDO TRANSFER IN", TXF_UNDO | TXF_DEBIT | TXF_TRANSFER, TXN_NONE);
+    define("SECURITY: DEPOSIT", TXF_SECURITY, TXN_NONE);
+    define("SECURITY: WITHDRAWAL", TXF_SECURITY, TXN_NONE);
+    define("SECURITY: TRANSFER_OUT", TXF_SECURITY, TXN_NONE);
+    define("SECURITY: TRANSFER_IN", TXF_SECURITY, TXN_NONE);
+}
+
+TransactionTypeTable::~TransactionTypeTable() {
+    delete[] names;
+    delete[] flagBits;
+    delete[] reversals;
+    delete[] slots;
+}
+
+int TransactionTypeTable::slotFor(const string& name) const {
+    int mask = slotCapacity - 1;
+    int pos = static_cast<int>(hashString(name) & mask);
+    while (slots[pos] != -1 && names[slots[pos]] != name) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+unsigned short TransactionTypeTable::define(const string& name, unsigned flags, unsigned short reversal) {
+    if (count == capacity) {
+        int newCapacity = capacity * 2;
+        string* grownNames = new string[newCapacity];
+        unsigned char* grownFlags = new unsigned char[newCapacity];
+        unsigned short* grownReversals = new unsigned short[newCapacity];
+        for (int i = 0; i < count; i++) {
+            grownNames[i] = names[i];
+            grownFlags[i] = flagBits[i];
+            grownReversals[i] = reversals[i];
+        }
+        delete[] names;
+        delete[] flagBits;
+        delete[] reversals;
+        names = grownNames;
+        flagBits = grownFlags;
+        reversals = grownReversals;
+        capacity = newCapacity;
+    }
+    names[count] = name;
+    flagBits[count] = static_cast<unsigned char>(flags);
+    reversals[count] = reversal;
+    if ((count + 1) * 2 > slotCapacity) {
+        delete[] slots;
+        slotCapacity *= 2;
+        slots = new int[slotCapacity];
+        for (int i = 0; i < slotCapacity; i++) {
+            slots[i] = -1;
+        }
+        for (int i = 0; i < count; i++) {
+            slots[slotFor(names[i])] = i;
+        }
+    }
+    slots[slotFor(name)] = count;
+    return static_cast<unsigned short>(count++);
+}
+
+unsigned short TransactionTypeTable::intern(const string& name) {
+    lock_guard<mutex> guard(internLock);
+    int pos = slotFor(name);
+    if (slots[pos] != -1) return static_cast<unsigned short>(slots[pos]);
+    unsigned flags = 0;
+    if (name.compare(0, 9, "SECURITY:") == 0) {
+        flags = TXF_SECURITY;
+    } else if (name.compare(0, 4, "UNDO") == 0) {
+        flags = TXF_UNDO;
+    }
+    return define(name, flags, TXN_NONE);
+}
+
+void TransactionHistory::reserve(int n) {
+    if (n <= capacity) return;
+    resizeColumn(timestamps, count, n);
+    resizeColumn(amounts, count, n);
+    resizeColumn(balances, count, n);
+    resizeColumn(types, count, n);
+    resizeColumn(ids, count, n);
+    resizeColumn(otherOffsets, count, n);
+    resizeColumn(otherLengths, count, n);
+    capacity = n;
+}
+
+unsigned int TransactionHistory::appendText(const string& value) {
+    if (textSize + value.length() > textCapacity) {
+        size_t newCapacity = textCapacity == 0 ? 256 : textCapacity * 2;
+        while (newCapacity < textSize + value.length()) newCapacity *= 2;
+        char* grown = new char[newCapacity];
+        if (textSize > 0) memcpy(grown, text, textSize);
+        delete[] text;
+        text = grown;
+        textCapacity = newCapacity;
+    }
+    unsigned int offset = static_cast<unsigned int>(textSize);
+    if (!value.empty()) memcpy(text + textSize, value.data(), value.length());
+    textSize += value.length();
+    return offset;
+}
+
+void TransactionHistory::addTransaction(const string& id, unsigned short type, Money amount, Money balanceAfter, const string& otherAccount, long timestamp) {
+    unsigned long long value;
+    if (!parseID(id, type, value)) {
+        value = TEXT_ID | (static_cast<unsigned long long>(id.length()) << 32) | appendText(id);
+    }
+    addTransaction(value, type, amount, balanceAfter, otherAccount, timestamp);
+}
+
+void TransactionHistory::addTransaction(unsigned long long id, unsigned short type, Money amount, Money balanceAfter, const string& otherAccount, long timestamp) {
+    if (count == capacity) {
+        reserve(capacity == 0 ? 8 : capacity * 2);
+    }
+    if (count > 0 && timestamp < timestamps[count - 1]) {
+        sorted = false;
+    }
+    timestamps[count] = timestamp;
+    amounts[count] = amount;
+    balances[count] = balanceAfter;
+    types[count] = type;
+    ids[count] = id;
+    otherOffsets[count] = appendText(otherAccount);
+    otherLengths[count] = static_cast<unsigned int>(otherAccount.length());
+    count++;
+}
+
+const char* TransactionHistory::idPrefix(unsigned short type) {
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    if (table.has(type, TXF_SECURITY)) return "SEC";
+    if (table.has(type, TXF_UNDO)) return "UNDO";
+    return "T";
+}
+
+bool TransactionHistory::parseID(const string& text, unsigned short type, unsigned long long& id) {
+    const char* prefix = idPrefix(type);
+    size_t length = strlen(prefix);
+    if (text.length() <= length || text.length() > length + 19 || text.compare(0, length, prefix) != 0) return false;
+    if (text[length] == '0' && text.length() > length + 1) return false;
+    unsigned long long value = 0;
+    for (size_t i = length; i < text.length(); i++) {
+        if (!isdigit(static_cast<unsigned char>(text[i]))) return false;
+        value = value * 10 + static_cast<unsigned long long>(text[i] - '0');
+    }
+    if ((value & TEXT_ID) != 0) return false;
+    id = value;
+    return true;
+}
+
+string TransactionHistory::idAt(int i) const {
+    if (isTextID(i)) {
+        return string(text + (ids[i] & 0xffffffffULL), static_cast<size_t>((ids[i] & ~TEXT_ID) >> 32));
+    }
+    return formatID(ids[i], types[i]);
+}
+
+size_t TransactionHistory::idChars(int i, char* buf, const char*& data) const {
+    if (isTextID(i)) {
+        data = text + (ids[i] & 0xffffffffULL);
+        return static_cast<size_t>((ids[i] & ~TEXT_ID) >> 32);
+    }
+    data = buf;
+    return static_cast<size_t>(snprintf(buf, ID_TEXT_SIZE, "%s%llu", idPrefix(types[i]), ids[i]));
+}
+
+TransactionHistory::Record TransactionHistory::get(int i) const {
+    Record record;
+    record.id = idAt(i);
+    record.type = types[i];
+    record.amount = amounts[i];
+    record.balanceAfter = balances[i];
+    record.otherAccount = otherAccountAt(i);
+    record.timestamp = static_cast<time_t>(timestamps[i]);
+    return record;
+}
+
+void TransactionHistory::removeAt(int i) {
+    for (int j = i; j + 1 < count; j++) {
+        timestamps[j] = timestamps[j + 1];
+        amounts[j] = amounts[j + 1];
+        balances[j] = balances[j + 1];
+        types[j] = types[j + 1];
+        ids[j] = ids[j + 1];
+        otherOffsets[j] = otherOffsets[j + 1];
+        otherLengths[j] = otherLengths[j + 1];
+    }
+    count--;
+}
+
+bool TransactionHistory::removeMatchingFromBack(unsigned short type, Money amount, const string& other) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (types[i] == type && amounts[i] == amount && otherLengths[i] == other.length() &&
+            memcmp(text + otherOffsets[i], other.data(), other.length()) == 0) {
+            removeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+int TransactionHistory::lowerBound(long long t) const {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (timestamps[mid] < t) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+int TransactionHistory::upperBound(long long t) const {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (timestamps[mid] <= t) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+int TransactionHistory::countRange(long long from, long long to) const {
+    if (from > to) return 0;
+    if (sorted) {
+        return upperBound(to) - lowerBound(from);
+    }
+    int matches = 0;
+    for (int i = 0; i < count; i++) {
+        if (timestamps[i] >= from && timestamps[i] <= to) matches++;
+    }
+    return matches;
+}
+
+int TransactionHistory::queryRange(long long from, long long to, int offset, int limit, int* rows) const {
+    int written = 0;
+    if (from > to || limit <= 0) return 0;
+    if (offset < 0) offset = 0;
+    if (sorted) {
+        // Compared before adding so a huge offset cannot overflow past
+        // the end; an offset beyond the range gives an empty page.
+        int first = lowerBound(from);
+        if (offset >= count - first) return 0;
+        for (int i = first + offset; i < count && timestamps[i] <= to && written < limit; i++) {
+            rows[written++] = i;
+        }
+        return written;
+    }
+    for (int i = 0; i < count && written < limit; i++) {
+        if (timestamps[i] < from || timestamps[i] > to) continue;
+        if (offset > 0) {
+            offset--;
+            continue;
+        }
+        rows[written++] = i;
+    }
+    return written;
+}
+
+int TransactionHistory::queryLast(int n, int* rows) const {
+    if (n > count) n = count;
+    for (int i = 0; i < n; i++) {
+        rows[i] = count - n + i;
+    }
+    return n < 0 ? 0 : n;
+}
+
+void TransactionHistory::release() {
+    delete[] timestamps;
+    delete[] amounts;
+    delete[] balances;
+    delete[] types;
+    delete[] ids;
+    delete[] otherOffsets;
+    delete[] otherLengths;
+    delete[] text;
+    timestamps = nullptr;
+    amounts = nullptr;
+    balances = nullptr;
+    types = nullptr;
+    ids = nullptr;
+    otherOffsets = nullptr;
+    otherLengths = nullptr;
+    text = nullptr;
+    count = 0;
+    capacity = 0;
+    textSize = 0;
+    textCapacity = 0;
+    sorted = true;
+}
+
+time_t PaymentPriorityQueue::occurrence(const PQNode* node, int k) {
+    time_t anchor = static_cast<time_t>(node->anchor);
+    if (node->unit == RECUR_SECONDS) {
+        return anchor + static_cast<time_t>(node->every) * k;
+    }
+    struct tm date = *localtime(&anchor);
+    date.tm_isdst = -1;
+    if (node->unit == RECUR_DAYS) {
+        date.tm_mday += node->every * k;
+        return mktime(&date);
+    }
+    int day = date.tm_mday;
+    date.tm_mon += node->every * k;
+    date.tm_mday = 1;
+    time_t first = mktime(&date);
+    date = *localtime(&first);
+    static const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year = date.tm_year + 1900;
+    int lastDay = monthDays[date.tm_mon];
+    if (date.tm_mon == 1 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) lastDay = 29;
+    date.tm_mday = day < lastDay ? day : lastDay;
+    date.tm_isdst = -1;
+    return mktime(&date);
+}
+
+bool PaymentPriorityQueue::reschedule(PQNode* node) {
+    if (!node->recurring()) return false;
+    node->fired++;
+    if (node->maxRuns > 0 && node->fired >= node->maxRuns) return false;
+    time_t next = occurrence(node, node->fired);
+    if (node->endAt != 0 && next > node->endAt) return false;
+    node->executeAt = next;
+    insert(node);
+    return true;
+}
+
+PaymentPriorityQueue::PaymentPriorityQueue() : heap(nullptr), capacity(16), count(0), nextSequence(0), idTable(nullptr), idCapacity(32) {
+    heap = new PQNode*[capacity];
+    idTable = new PQNode*[idCapacity];
+    for (int i = 0; i < idCapacity; i++) {
+        idTable[i] = nullptr;
+    }
+}
+
+void PaymentPriorityQueue::siftUp(int slot) {
+    PQNode* node = heap[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!before(node, heap[parent])) break;
+        place(heap[parent], slot);
+        slot = parent;
+    }
+    place(node, slot);
+}
+
+void PaymentPriorityQueue::siftDown(int slot) {
+    PQNode* node = heap[slot];
+    while (true) {
+        int child = 2 * slot + 1;
+        if (child >= count) break;
+        if (child + 1 < count && before(heap[child + 1], heap[child])) child++;
+        if (!before(heap[child], node)) break;
+        place(heap[child], slot);
+        slot = child;
+    }
+    place(node, slot);
+}
+
+int PaymentPriorityQueue::idSlot(const string& id) const {
+    int mask = idCapacity - 1;
+    int pos = static_cast<int>(hashString(id) & mask);
+    while (idTable[pos] != nullptr && idTable[pos]->id != id) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void PaymentPriorityQueue::indexId(PQNode* node) {
+    if ((count + 1) * 2 > idCapacity) {
+        PQNode** old = idTable;
+        int oldCapacity = idCapacity;
+        idCapacity *= 2;
+        idTable = new PQNode*[idCapacity];
+        for (int i = 0; i < idCapacity; i++) {
+            idTable[i] = nullptr;
+        }
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != nullptr) idTable[idSlot(old[i]->id)] = old[i];
+        }
+        delete[] old;
+    }
+    int pos = idSlot(node->id);
+    if (idTable[pos] == nullptr) {
+        idTable[pos] = node;
+    }
+}
+
+void PaymentPriorityQueue::unindexId(PQNode* node) {
+    int mask = idCapacity - 1;
+    int hole = idSlot(node->id);
+    if (idTable[hole] != node) return;
+    int next = (hole + 1) & mask;
+    while (idTable[next] != nullptr) {
+        int home = static_cast<int>(hashString(idTable[next]->id) & mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            idTable[hole] = idTable[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    idTable[hole] = nullptr;
+}
+
+void PaymentPriorityQueue::insert(PQNode* newNode) {
+    newNode->sequence = nextSequence++;
+    if (count == capacity) {
+        PQNode** grown = new PQNode*[capacity * 2];
+        for (int i = 0; i < count; i++) {
+            grown[i] = heap[i];
+        }
+        delete[] heap;
+        heap = grown;
+        capacity *= 2;
+    }
+    indexId(newNode);
+    heap[count] = newNode;
+    count++;
+    siftUp(count - 1);
+}
+
+PaymentPriorityQueue::PQNode* PaymentPriorityQueue::removeAt(int slot) {
+    PQNode* node = heap[slot];
+    unindexId(node);
+    count--;
+    if (slot != count) {
+        place(heap[count], slot);
+        if (slot > 0 && before(heap[slot], heap[(slot - 1) / 2])) {
+            siftUp(slot);
+        } else {
+            siftDown(slot);
+        }
+    }
+    node->slot = -1;
+    return node;
+}
+
+PaymentPriorityQueue::PQNode** PaymentPriorityQueue::takeDue(time_t now, int limit, int& taken) {
+    taken = 0;
+    if (count == 0 || heap[0]->executeAt > now || limit <= 0) return new PQNode*[1];
+    if (limit < count / 16) {
+        PQNode** due = new PQNode*[limit];
+        while (taken < limit && count > 0 && heap[0]->executeAt <= now) {
+            due[taken++] = removeAt(0);
+        }
+        return due;
+    }
+    PQNode** due = new PQNode*[count];
+    int* pending = new int[count];
+    int found = 0;
+    int depth = 0;
+    pending[depth++] = 0;
+    while (depth > 0) {
+        int slot = pending[--depth];
+        due[found++] = heap[slot];
+        for (int child = 2 * slot + 1; child <= 2 * slot + 2 && child < count; child++) {
+            if (heap[child]->executeAt <= now) pending[depth++] = child;
+        }
+    }
+    delete[] pending;
+    sort(due, due + found, before);
+    taken = found < limit ? found : limit;
+    if (taken > count / 16) {
+        for (int i = 0; i < taken; i++) {
+            unindexId(due[i]);
+            due[i]->slot = -1;
+        }
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (heap[i]->slot != -1) place(heap[i], kept++);
+        }
+        count = kept;
+        for (int slot = count / 2 - 1; slot >= 0; slot--) {
+            siftDown(slot);
+        }
+    } else {
+        for (int i = 0; i < taken; i++) {
+            removeAt(due[i]->slot);
+        }
+    }
+    return due;
+}
+
+void PaymentPriorityQueue::clear() {
+    for (int i = 0; i < count; i++) {
+        delete heap[i];
+    }
+    for (int i = 0; i < idCapacity; i++) {
+        idTable[i] = nullptr;
+    }
+    count = 0;
+}
+
+void PaymentPriorityQueue::sortByExecution(PQNode** nodes, int n) {
+    for (int start = n / 2 - 1; start >= 0; start--) {
+        siftLatest(nodes, start, n);
+    }
+    for (int end = n - 1; end > 0; end--) {
+        PQNode* tmp = nodes[0];
+        nodes[0] = nodes[end];
+        nodes[end] = tmp;
+        siftLatest(nodes, 0, end);
+    }
+}
+
+void PaymentPriorityQueue::siftLatest(PQNode** nodes, int slot, int n) {
+    while (true) {
+        int child = 2 * slot + 1;
+        if (child >= n) break;
+        if (child + 1 < n && before(nodes[child], nodes[child + 1])) child++;
+        if (!before(nodes[slot], nodes[child])) break;
+        PQNode* tmp = nodes[slot];
+        nodes[slot] = nodes[child];
+        nodes[child] = tmp;
+        slot = child;
+    }
+}
+
+void Journal::appendEscaped(string& out, const string& field) {
+    if (field.find_first_of("\\\t\n") == string::npos) {
+        out += field;
+        return;
+    }
+    for (size_t i = 0; i < field.length(); i++) {
+        char c = field[i];
+        if (c == '\\') out += "\\\\";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+}
+
+int Journal::parse(const string& line, string* fields, int maxFields) {
+    if (line.length() < 17 || line[16] != ' ') return -1;
+    string body = line.substr(17);
+    if (checksum(body) != line.substr(0, 16)) return -1;
+    int n = 0;
+    string current;
+    for (size_t i = 0; i <= body.length(); i++) {
+        if (i == body.length() || body[i] == '\t') {
+            if (n == maxFields) return -1;
+            fields[n++] = current;
+            current.clear();
+        } else if (body[i] == '\\' && i + 1 < body.length()) {
+            i++;
+            if (body[i] == 't') current += '\t';
+            else if (body[i] == 'n') current += '\n';
+            else current += body[i];
+        } else {
+            current += body[i];
+        }
+    }
+    return n;
+}
+
+void Journal::append(const string* fields, int count) {
+    if (fd == -1 || suspended) return;
+    string body;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) body += '\t';
+        appendEscaped(body, fields[i]);
+    }
+    Record* record = new Record();
+    record->line.reserve(body.length() + 18);
+    record->line += checksum(body);
+    record->line += ' ';
+    record->line += body;
+    record->line += '\n';
+    record->next = queued.load();
+    while (!queued.compare_exchange_weak(record->next, record)) {
+    }
+    // Counted only once it is on the stack, so a count a committer sees
+    // covers records the write it asks for is sure to take; counting first
+    // let it wait on another thread's record that missed that write.
+    queuedCount.fetch_add(1);
+}
+
+bool Journal::writeAll(const string& data, size_t& written) {
+    written = 0;
+    while (written < data.length()) {
+        ssize_t n = ::write(fd, data.data() + written, data.length() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+int Journal::takeQueued(string& data) {
+    Record* record = queued.exchange(nullptr);
+    Record* oldest = nullptr;
+    int count = 0;
+    while (record != nullptr) {
+        Record* next = record->next;
+        record->next = oldest;
+        oldest = record;
+        record = next;
+        count++;
+    }
+    while (oldest != nullptr) {
+        Record* next = oldest->next;
+        data += oldest->line;
+        delete oldest;
+        oldest = next;
+    }
+    return count;
+}
+
+bool Journal::flushLocked() {
+    string data;
+    int count = takeQueued(data);
+    bool ok = fd != -1;
+    if (count > 0) {
+        size_t written = 0;
+        const char* step = "write";
+        if (ok && !writeAll(data, written)) {
+            ok = false;
+        } else if (ok && ::fsync(fd) != 0) {
+            ok = false;
+            step = "sync";
+        }
+        int error = errno;
+        bytes += static_cast<long long>(written);
+        durableCount += count;
+        if (!ok && !failed.exchange(true)) {
+            walletNotice("Error: journal " + string(step) + " to " + fileName + " failed (" +
+                         (fd == -1 ? string("not open") : string(strerror(error))) + "), " +
+                         to_string(data.length() - written) + " byte(s) not written");
+        }
+        durableChanged.notify_all();
+    }
+    return ok && !failed;
+}
+
+bool Journal::commit() {
+    if (!writer.joinable()) return sync();
+    long long ticket = queuedCount.load();
+    {
+        lock_guard<mutex> guard(writerLock);
+        writeRequested = true;
+    }
+    writerWake.notify_one();
+    if (mode == DURABILITY_GROUP) {
+        unique_lock<mutex> lock(writeLock);
+        while (durableCount < ticket && !failed) {
+            durableChanged.wait(lock);
+        }
+    }
+    return fd != -1 && !failed;
+}
+
+void Journal::startWriter(const DurabilityConfig& config) {
+    stopWriter();
+    mode = config.mode;
+    windowMicros = config.windowMicros;
+    if (mode == DURABILITY_SYNC) return;
+    writerStopping = false;
+    writer = thread(&Journal::runWriter, this);
+}
+
+void Journal::stopWriter() {
+    if (!writer.joinable()) return;
+    {
+        lock_guard<mutex> guard(writerLock);
+        writerStopping = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+    sync();
+}
+
+void Journal::runWriter() {
+    unique_lock<mutex> lock(writerLock);
+    while (true) {
+        while (!writeRequested && !writerStopping) {
+            writerWake.wait(lock);
+        }
+        if (writerStopping) return;
+        writeRequested = false;
+        lock.unlock();
+        if (windowMicros > 0) this_thread::sleep_for(chrono::microseconds(windowMicros));
+        sync();
+        lock.lock();
+    }
+}
+
+bool Journal::open(const string& name, long long gen, long long validBytes) {
+    close();
+    fileName = name;
+    if (validBytes <= 0) {
+        return reset(gen);
+    }
+    lock_guard<mutex> guard(writeLock);
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT, 0600);
+    if (fd == -1) return false;
+    if (::ftruncate(fd, validBytes) != 0 || ::lseek(fd, 0, SEEK_END) < 0) {
+        closeFile();
+        return false;
+    }
+    generation = gen;
+    bytes = validBytes;
+    cleanBytes = -1;
+    failed = false;
+    return true;
+}
+
+bool Journal::reset(long long gen) {
+    lock_guard<mutex> guard(writeLock);
+    closeFile();
+    string dropped;
+    durableCount += takeQueued(dropped);
+    durableChanged.notify_all();
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    generation = gen;
+    bytes = 0;
+    failed = false;
+    if (fd == -1) return false;
+    string header[] = {"JOURNAL", to_string(gen)};
+    append(header, 2);
+    bool ok = flushLocked();
+    cleanBytes = bytes;
+    return ok;
+}
+
+void Journal::closeFile() {
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool MappedFile::open(const string& fileName) {
+    close();
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size == 0) return true;
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data != nullptr) {
+        ::munmap(const_cast<char*>(data), size);
+        data = nullptr;
+    }
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+string User::generateAccountNumber() {
+    string accNum = "ACC";
+    for (int i = 0; i < 10; i++) {
+        accNum += to_string(rand() % 10);
+    }
+    return accNum;
+}
+
+string User::getCurrentDate() {
+    time_t t = time(nullptr);
+    struct tm *tm_info = localtime(&t);
+    char buf[20];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", tm_info);
+    return string(buf);
+}
+
+bool User::isWeakPassword(const string& pwd) {
+    if (pwd.length() < 4) return true;
+    const char* weakPasswords[] = {
+        "password", "123456", "1234", "0000", "admin",
+        "qwerty", "letmein", "welcome", "pass", "1111"
+    };
+    int weakCount = 10;
+    for (int i = 0; i < weakCount; i++) {
+        if (pwd == weakPasswords[i]) return true;
+    }
+    bool allSame = true;
+    for (int i = 1; i < (int)pwd.length(); i++) {
+        if (pwd[i] != pwd[0]) {
+            allSame = false;
+            break;
+        }
+    }
+    if (allSame) return true;
+    return false;
+}
+
+bool User::isWeakPIN(const string& pin) {
+    if (pin.length() != 4) return false;
+    bool sequentialAsc = true;
+    bool sequentialDesc = true;
+    for (int i = 1; i < 4; i++) {
+        if (pin[i] != pin[i-1] + 1) sequentialAsc = false;
+        if (pin[i] != pin[i-1] - 1) sequentialDesc = false;
+    }
+    if (sequentialAsc || sequentialDesc) return true;
+    bool allSame = true;
+    for (int i = 1; i < 4; i++) {
+        if (pin[i] != pin[0]) {
+            allSame = false;
+            break;
+        }
+    }
+    if (allSame) return true;
+    const char* weakPINs[] = {"0000", "1111", "2222", "3333", "4444","5555", "6666", "7777", "8888", "9999","1234", "4321", "1122", "1212"};
+    int weakCount = 14;
+    for (int i = 0; i < weakCount; i++) {
+        if (pin == weakPINs[i]) return true;
+    }
+    return false;
+}
+
+bool User::setEmail(const string &e) {
+    if (e.empty() || e.length() > 50) return false;
+    size_t at_pos = e.find('@');
+    if (at_pos == string::npos) return false;
+    size_t dot_pos = e.find('.', at_pos + 1);
+    if (dot_pos == string::npos) return false;
+    if (dot_pos <= at_pos + 1) return false;
+    email = e;
+    logField("email", email);
+    return true;
+}
+
+bool User::setPhone(const string &p) {
+    if (p.empty() || p.length() < 10 || p.length() > 15) return false;
+    for (int i = 0; i < (int)p.length(); i++) {
+        char c = p[i];
+        if (!isdigit(c) && c != '+' && c != '-' && c != ' ' && c != '(' && c != ')') return false;
+    }
+    phone = p;
+    logField("phone", phone);
+    return true;
+}
+
+bool User::setAddress(const string &a) {
+    if (a.empty() || a.length() > 100) return false;
+    address = a;
+    logField("address", address);
+    return true;
+}
+
+bool User::setPassword(const string &pwd) {
+    if (pwd.length() < 4 || pwd.length() > 20) return false;
+    if (isWeakPassword(pwd)) return false;
+    password = pwd;
+    logField("password", password);
+    return true;
+}
+
+bool User::setPIN(const string &p) {
+    if (p.length() != 4) return false;
+    for (int i = 0; i < 4; i++) {
+        if (!isdigit(p[i])) return false;
+    }
+    if (isWeakPIN(p)) return false;
+    pin = p;
+    logField("pin", pin);
+    return true;
+}
+
+void User::logField(const string& field, const string& value) {
+    dirty = true;
+    if (journal == nullptr) return;
+    string fields[] = {"F", accountNumber, field, value};
+    journal->append(fields, 4);
+}
+
+void User::logAuthState() {
+    dirty = true;
+    if (journal == nullptr) return;
+    string fields[] = {"A", accountNumber, to_string(loginAttempts), to_string(lastLoginAttempt), isLocked ? "1" : "0"};
+    journal->append(fields, 5);
+}
+
+void User::logTransaction(unsigned long long id, unsigned short type, Money amount, Money balanceAfter, const string& otherAccount, long timestamp, bool undoable, Money balanceBefore,
+                          unsigned long long transfer) {
+    dirty = true;
+    if (journal == nullptr) return;
+    string fields[] = {"T", accountNumber, TransactionHistory::formatID(id, type), TransactionTypeTable::instance().name(type), amount.format(), balanceAfter.format(),
+                       otherAccount, to_string(timestamp), undoable ? "1" : "0", balanceBefore.format(), to_string(transfer)};
+    journal->append(fields, transfer != 0 ? 11 : 10);
+}
+
+void User::logUndoRemoved(const unsigned long long* ids, int n) {
+    dirty = true;
+    if (journal == nullptr) return;
+    string fields[2 + SecurityConfig::UNDO_DEPTH];
+    fields[0] = "P";
+    fields[1] = accountNumber;
+    for (int i = 0; i < n; i++) {
+        fields[2 + i] = to_string(ids[i]);
+    }
+    journal->append(fields, 2 + n);
+}
+
+bool User::verifyPIN(string inputPIN) {
+    TIME_OPERATION(METRIC_PIN_CHECK);
+    int oldAttempts = loginAttempts;
+    bool oldLocked = isLocked;
+    bool verified = checkPIN(inputPIN);
+    if (loginAttempts != oldAttempts || isLocked != oldLocked) {
+        logAuthState();
+    }
+    return verified;
+}
+
+bool User::verifyPassword(string inputPassword) {
+    int oldAttempts = loginAttempts;
+    bool oldLocked = isLocked;
+    bool verified = checkPassword(inputPassword);
+    if (loginAttempts != oldAttempts || isLocked != oldLocked) {
+        logAuthState();
+    }
+    return verified;
+}
+
+bool User::checkPIN(const string& inputPIN) {
+    if (isLocked) {
+        long now = static_cast<long>(time(nullptr));
+        if (now - lastLoginAttempt > SecurityConfig::ACCOUNT_LOCKOUT_TIME) {
+            isLocked = false;
+            loginAttempts = 0;
+        } else {
+            return false;
+        }
+    }
+    if (pin == inputPIN) {
+        loginAttempts = 0;
+        return true;
+    } else {
+        loginAttempts++;
+        lastLoginAttempt = static_cast<long>(time(nullptr));
+        if (loginAttempts >= SecurityConfig::MAX_LOGIN_ATTEMPTS) {
+            isLocked = true;
+        }
+        return false;
+    }
+}
+
+bool User::checkPassword(const string& inputPassword) {
+    if (isLocked) {
+        long now = static_cast<long>(time(nullptr));
+        if (now - lastLoginAttempt > SecurityConfig::ACCOUNT_LOCKOUT_TIME) {
+            isLocked = false;
+            loginAttempts = 0;
+        } else {
+            return false;
+        }
+    }
+    if (password == inputPassword) {
+        loginAttempts = 0;
+        return true;
+    } else {
+        loginAttempts++;
+        lastLoginAttempt = static_cast<long>(time(nullptr));
+        if (loginAttempts >= SecurityConfig::MAX_LOGIN_ATTEMPTS) {
+            isLocked = true;
+        }
+        return false;
+    }
+}
+
+unsigned long long User::addTransactionRecord(unsigned short type, Money amount, Money balanceAfter, const string &otherAccount, unsigned long long transfer) {
+    unsigned long long id = IDGenerator::instance().next();
+    long now = time(nullptr);
+    Money balanceBefore = balance;
+    balance = balanceAfter;
+    transactions.addTransaction(id, type, amount, balanceAfter, otherAccount, now);
+    bool undoable = !TransactionTypeTable::instance().has(type, TXF_UNDO | TXF_SECURITY);
+    if (undoable) {
+        undoRing.expire(now);
+        undoRing.push(id, type, amount, balanceBefore, balanceAfter, otherAccount, now, transfer);
+    }
+    logTransaction(id, type, amount, balanceAfter, otherAccount, now, undoable, balanceBefore, undoable ? transfer : 0);
+    return id;
+}
+
+void User::addTransactionRecords(const unsigned short* types, const Money* amounts, const Money* balancesAfter,
+                                 const string* const* otherAccounts, int n) {
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    long now = time(nullptr);
+    if (transactions.count + n > transactions.capacity) {
+        int doubled = transactions.capacity * 2;
+        transactions.reserve(doubled > transactions.count + n ? doubled : transactions.count + n);
+    }
+    undoRing.expire(now);
+    Money balanceBefore = balance;
+    for (int i = 0; i < n; i++) {
+        unsigned long long id = IDGenerator::instance().next();
+        transactions.addTransaction(id, types[i], amounts[i], balancesAfter[i], *otherAccounts[i], now);
+        bool undoable = !table.has(types[i], TXF_UNDO | TXF_SECURITY);
+        if (undoable) {
+            undoRing.push(id, types[i], amounts[i], balanceBefore, balancesAfter[i], *otherAccounts[i], now, 0);
+        }
+        logTransaction(id, types[i], amounts[i], balancesAfter[i], *otherAccounts[i], now, undoable, balanceBefore);
+        balanceBefore = balancesAfter[i];
+    }
+    balance = balanceBefore;
+}
+
+void User::addReversal(const UndoRing::Entry& entry, long now) {
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    unsigned long long id = IDGenerator::instance().next();
+    unsigned short type = table.reversal(entry.type);
+    string other = table.has(entry.type, TXF_TRANSFER) ? entry.otherAccount : "";
+    Money oldBalance = balance;
+    balance = table.has(entry.type, TXF_CREDIT) ? balance - entry.amount : balance + entry.amount;
+    transactions.addTransaction(id, type, entry.amount, balance, other, now);
+    logTransaction(id, type, entry.amount, balance, other, now, false, oldBalance);
+}
+
+void User::addSecurityLog(unsigned short type, const string &details) {
+    unsigned long long id = IDGenerator::instance().next();
+    long now = time(nullptr);
+    transactions.addTransaction(id, type, Money(), balance, details, now);
+    logTransaction(id, type, Money(), balance, details, now, false, balance);
+}
+
+void User::saveToFile(ofstream& file) {
+    file << name << endl;
+    file << userID << endl;
+    file << password << endl;
+    file << pin << endl;
+    file << accountNumber << endl;
+    file << email << endl;
+    file << phone << endl;
+    file << address << endl;
+    file << accountType << endl;
+    file << balance.format() << endl;
+    file << dateCreated << endl;
+    file << loginAttempts << endl;
+    file << lastLoginAttempt << endl;
+    file << isLocked << endl;
+    file << transactions.getCount() << endl;
+    for (int i = 0; i < transactions.getCount(); i++) {
+        file << transactions.idAt(i) << endl;
+        file << transactions.typeAt(i) << endl;
+        file << transactions.amounts[i].format() << endl;
+        file << transactions.balances[i].format() << endl;
+        file << transactions.otherAccountAt(i) << endl;
+        file << transactions.timestamps[i] << endl;
+    }
+    int undoCount = undoRing.live(static_cast<long>(time(nullptr)));
+    file << undoCount << endl;
+    for (int k = 0; k < undoCount; k++) {
+        UndoRing::Entry* entry = undoRing.newest(k);
+        file << TransactionHistory::formatID(entry->id, entry->type) << endl;
+        file << TransactionTypeTable::instance().name(entry->type) << endl;
+        file << entry->amount.format() << endl;
+        file << entry->balanceBefore.format() << endl;
+        file << entry->balanceAfter.format() << endl;
+        file << entry->otherAccount << endl;
+        file << entry->timestamp << endl;
+    }
+}
+
+bool User::loadFromText(TextCursor& in) {
+    in.readLine(name);
+    in.readLine(userID);
+    in.readLine(password);
+    in.readLine(pin);
+    in.readLine(accountNumber);
+    in.readLine(email);
+    in.readLine(phone);
+    in.readLine(address);
+    in.readLine(accountType);
+    in.readMoney(balance);
+    in.skipLineEnd();
+    in.readLine(dateCreated);
+    long long locked = 0;
+    in.readInt(loginAttempts);
+    long long lastAttempt = 0;
+    if (in.readLong(lastAttempt)) lastLoginAttempt = static_cast<long>(lastAttempt);
+    if (in.readLong(locked)) isLocked = locked != 0;
+    in.skipLineEnd();
+    transactions.clear();
+    int count = 0;
+    if (in.readInt(count)) {
+        in.skipLineEnd();
+        transactions.reserve(count < TransactionHistory::MAX_RESERVE ? count : TransactionHistory::MAX_RESERVE);
+        string id, type, otherAccount;
+        for (int i = 0; i < count && !in.atEnd(); ++i) {
+            Money amount, balanceAfter;
+            long long timestamp = 0;
+            in.readLine(id);
+            in.readLine(type);
+            in.readMoney(amount);
+            in.readMoney(balanceAfter);
+            in.skipLineEnd();
+            in.readLine(otherAccount);
+            in.readLong(timestamp);
+            in.skipLineEnd();
+            if (in.failed) break;
+            transactions.addTransaction(id, TransactionTypeTable::instance().intern(type), amount, balanceAfter, otherAccount, static_cast<long>(timestamp));
+        }
+    }
+    undoRing.clear();
+    int undoCount = 0;
+    if (in.readInt(undoCount)) {
+        in.skipLineEnd();
+        string id, type, otherAccount;
+        for (int i = 0; i < undoCount && !in.atEnd(); ++i) {
+            Money amount, balanceBefore, balanceAfter;
+            long long timestamp = 0;
+            in.readLine(id);
+            in.readLine(type);
+            in.readMoney(amount);
+            in.readMoney(balanceBefore);
+            in.readMoney(balanceAfter);
+            in.skipLineEnd();
+            in.readLine(otherAccount);
+            in.readLong(timestamp);
+            in.skipLineEnd();
+            if (in.failed) break;
+            unsigned short code = TransactionTypeTable::instance().intern(type);
+            undoRing.pushOldest(TransactionHistory::idValue(id, code), code, amount, balanceBefore, balanceAfter, otherAccount, static_cast<long>(timestamp));
+        }
+        undoRing.expire(static_cast<long>(time(nullptr)));
+    }
+    return !in.failed;
+}
+
+void User::saveBinary(SnapshotWriter& out) {
+    out.putString(name);
+    out.putString(userID);
+    out.putString(password);
+    out.putString(pin);
+    out.putString(accountNumber);
+    out.putString(email);
+    out.putString(phone);
+    out.putString(address);
+    out.putString(accountType);
+    out.putMoney(balance);
+    out.putString(dateCreated);
+    out.putU32(static_cast<unsigned long>(loginAttempts));
+    out.putI64(lastLoginAttempt);
+    out.putU8(isLocked ? 1 : 0);
+    out.putU32(static_cast<unsigned long>(transactions.getCount()));
+    for (int i = 0; i < transactions.getCount(); i++) {
+        if (transactions.isTextID(i)) {
+            out.putI64(-1);
+            out.putString(transactions.idAt(i));
+        } else {
+            out.putI64(static_cast<long long>(transactions.ids[i]));
+        }
+        out.putType(transactions.types[i]);
+        out.putMoney(transactions.amounts[i]);
+        out.putMoney(transactions.balances[i]);
+        out.putString(transactions.otherAccountAt(i));
+        out.putI64(transactions.timestamps[i]);
+    }
+    int undoCount = undoRing.live(static_cast<long>(time(nullptr)));
+    out.putU32(static_cast<unsigned long>(undoCount));
+    for (int k = 0; k < undoCount; k++) {
+        UndoRing::Entry* entry = undoRing.newest(k);
+        out.putI64(static_cast<long long>(entry->id));
+        out.putType(entry->type);
+        out.putMoney(entry->amount);
+        out.putMoney(entry->balanceBefore);
+        out.putMoney(entry->balanceAfter);
+        out.putString(entry->otherAccount);
+        out.putI64(entry->timestamp);
+        out.putI64(static_cast<long long>(entry->transfer));
+    }
+}
+
+bool User::loadBinary(SnapshotReader& in) {
+    name = in.getString();
+    userID = in.getString();
+    password = in.getString();
+    pin = in.getString();
+    accountNumber = in.getString();
+    email = in.getString();
+    phone = in.getString();
+    address = in.getString();
+    accountType = in.getString();
+    balance = in.getMoney();
+    dateCreated = in.getString();
+    loginAttempts = static_cast<int>(in.getU32());
+    lastLoginAttempt = static_cast<long>(in.getI64());
+    isLocked = in.getU8() != 0;
+    transactions.clear();
+    unsigned long count = in.getU32();
+    transactions.reserve(static_cast<int>(count < TransactionHistory::MAX_RESERVE ? count : TransactionHistory::MAX_RESERVE));
+    for (unsigned long i = 0; i < count && in.ok; i++) {
+        long long number = -1;
+        string id;
+        if (in.version >= 6) number = in.getI64();
+        if (number < 0) id = in.getString();
+        unsigned short type = in.getType();
+        Money amount = in.getMoney();
+        Money balanceAfter = in.getMoney();
+        string otherAccount = in.getString();
+        long timestamp = static_cast<long>(in.getI64());
+        if (number < 0) {
+            transactions.addTransaction(id, type, amount, balanceAfter, otherAccount, timestamp);
+        } else {
+            transactions.addTransaction(static_cast<unsigned long long>(number), type, amount, balanceAfter, otherAccount, timestamp);
+        }
+    }
+    undoRing.clear();
+    unsigned long undoCount = in.getU32();
+    for (unsigned long i = 0; i < undoCount && in.ok; i++) {
+        long long number = 0;
+        string id;
+        if (in.version >= 6) number = in.getI64();
+        else id = in.getString();
+        unsigned short type = in.getType();
+        Money amount = in.getMoney();
+        Money balanceBefore = in.getMoney();
+        Money balanceAfter = in.getMoney();
+        string otherAccount = in.getString();
+        long timestamp = static_cast<long>(in.getI64());
+        long long transfer = in.version >= 7 ? in.getI64() : 0;
+        if (in.version < 6) number = static_cast<long long>(TransactionHistory::idValue(id, type));
+        undoRing.pushOldest(static_cast<unsigned long long>(number), type, amount, balanceBefore, balanceAfter, otherAccount, timestamp,
+                            static_cast<unsigned long long>(transfer));
+    }
+    undoRing.expire(static_cast<long>(time(nullptr)));
+    return in.ok;
+}
+
+void UserIndex::allocate(int newCapacity) {
+    entries = new Entry[newCapacity];
+    capacity = newCapacity;
+    for (int i = 0; i < capacity; i++) {
+        entries[i].hash = 0;
+        entries[i].userIndex = -1;
+    }
+}
+
+void UserIndex::grow() {
+    Entry* old = entries;
+    int oldCapacity = capacity;
+    allocate(capacity * 2);
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i].userIndex == -1) continue;
+        int pos = static_cast<int>(old[i].hash & (capacity - 1));
+        while (entries[pos].userIndex != -1) {
+            pos = (pos + 1) & (capacity - 1);
+        }
+        entries[pos] = old[i];
+    }
+    delete[] old;
+}
+
+int UserIndex::findSlot(const string& key, unsigned long long h, User** users) const {
+    int pos = static_cast<int>(h & (capacity - 1));
+    while (entries[pos].userIndex != -1) {
+        if (entries[pos].hash == h && users[entries[pos].userIndex]->*field == key) {
+            return pos;
+        }
+        pos = (pos + 1) & (capacity - 1);
+    }
+    return -1;
+}
+
+bool UserIndex::insert(int userIndex, User** users) {
+    const string& key = users[userIndex]->*field;
+    unsigned long long h = hashString(key);
+    if (findSlot(key, h, users) != -1) return false;
+    if ((count + 1) * 2 > capacity) {
+        grow();
+    }
+    int pos = static_cast<int>(h & (capacity - 1));
+    while (entries[pos].userIndex != -1) {
+        pos = (pos + 1) & (capacity - 1);
+    }
+    entries[pos].hash = h;
+    entries[pos].userIndex = userIndex;
+    count++;
+    return true;
+}
+
+bool UserIndex::remove(const string& key, int userIndex, User** users) {
+    int pos = findSlot(key, hashString(key), users);
+    if (pos == -1 || entries[pos].userIndex != userIndex) return false;
+    int mask = capacity - 1;
+    int hole = pos;
+    int next = (hole + 1) & mask;
+    while (entries[next].userIndex != -1) {
+        int home = static_cast<int>(entries[next].hash & mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            entries[hole] = entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    entries[hole].hash = 0;
+    entries[hole].userIndex = -1;
+    count--;
+    return true;
+}
+
+void UserIndex::clear() {
+    for (int i = 0; i < capacity; i++) {
+        entries[i].hash = 0;
+        entries[i].userIndex = -1;
+    }
+    count = 0;
+}
+
+BankingSystem::BankingSystem(bool persist) : capacity(10), userCount(0), nextUserID(1000), invalidIDAttempts(0), dataFileName("bank_data.txt"),
+                  snapshotFileName("bank_data.bin"), persistent(persist),
+                  accountIndex(&User::accountNumber), userIDIndex(&User::userID), emailIndex(&User::email),
+                  segmentFiles(nullptr), segmentCapacity(0), checkpointDone(false), checkpointOk(false), checkpointSegments(nullptr), checkpointSegmentCount(0),
+                  checkpointOutput(nullptr),
+                  journalFileName("bank_data.journal"), schedulerStopping(false), scheduledRun(0), scheduledBatches(0),
+                  scheduledSettled(0), totalLatenessMs(0), maxLatenessMs(0) {
+    users = new User*[capacity];
+    for (int i = 0; i < capacity; i++) {
+        users[i] = nullptr;
+    }
+    if (!persistent) return;
+    loadFromFile();
+    replayJournal();
+    for (int i = 0; i < userCount; i++) {
+        users[i]->journal = &journal;
+    }
+    journal.startWriter(DurabilityConfig::current());
+}
+
+BankingSystem::~BankingSystem() {
+    stopScheduler();
+    finishBackgroundCheckpoint(true);
+    if (persistent && !journal.isClean()) {
+        saveToFile();
+    }
+    clearUsers();
+    delete[] users;
+    delete[] segmentFiles;
+}
+
+void BankingSystem::clearUsers() {
+    for (int i = 0; i < userCount; i++) {
+        if (users[i] != nullptr) {
+            delete users[i];
+            users[i] = nullptr; 
+        }
+    }
+    userCount = 0;
+    rebuildIndexes();
+}
+
+bool BankingSystem::isValidName(const string& name) {
+    if (name.empty() || name.length() < 2 || name.length() > 50) return false;
+    for (int i = 0; i < (int)name.length(); i++) {
+        char c = name[i];
+        if (!isalpha(c) && c != ' ' && c != '.' && c != '-') return false;
+    }
+    return true;
+}
+
+bool BankingSystem::isValidEmail(const string& email) {
+    if (email.empty() || email.length() > 50) return false;
+    size_t at_pos = email.find('@');
+    if (at_pos == string::npos) return false;
+    size_t dot_pos = email.find('.', at_pos + 1);
+    if (dot_pos == string::npos) return false;
+    if (dot_pos <= at_pos + 1) return false;
+    return true;
+}
+
+bool BankingSystem::isValidPIN(const string& pin) {
+    if (pin.length() != 4) return false;
+    for (int i = 0; i < 4; i++) {
+        if (!isdigit(pin[i])) return false;
+    }
+    return true;
+}
+
+bool BankingSystem::isValidPhone(const string& phone) {
+    if (phone.empty() || phone.length() < 10 || phone.length() > 15) return false;
+    for (int i = 0; i < (int)phone.length(); i++) {
+        char c = phone[i];
+        if (!isdigit(c) && c != '+' && c != '-' && c != ' ' && c != '(' && c != ')') return false;
+    }
+    return true;
+}
+
+void BankingSystem::resizeArray() {
+    int newCapacity = capacity * 2;
+    User** newUsers = new User*[newCapacity];
+    for (int i = 0; i < userCount; i++) {
+        newUsers[i] = users[i];
+    }
+    for (int i = userCount; i < newCapacity; i++) {
+        newUsers[i] = nullptr;
+    }
+    delete[] users;
+    users = newUsers;
+    capacity = newCapacity;
+}
+
+void BankingSystem::rebuildIndexes() {
+    accountIndex.clear();
+    userIDIndex.clear();
+    emailIndex.clear();
+    for (int i = 0; i < userCount; i++) {
+        indexUser(i);
+    }
+}
+
+string BankingSystem::generateUserID() {
+    string id;
+    do {
+        id = "USER" + to_string(nextUserID);
+        nextUserID++;
+    } while (!isUserIDUnique(id));
+    return id;
+}
+
+// Orders the sides of a scheduled batch (2 * i for payment i's sender,
+// 2 * i + 1 for its recipient) by user slot, in batch order within a user.
+struct ScheduledSideOrder {
+    const int* accounts;
+    bool operator()(int a, int b) const {
+        return accounts[a] != accounts[b] ? accounts[a] < accounts[b] : a < b;
+    }
+};
+
+int BankingSystem::processScheduledPayments(int limit) {
+    TIME_OPERATION(METRIC_SCHEDULED_PAYMENTS);
+    long long nowMs = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    long currentTime = static_cast<long>(nowMs / 1000);
+    int processed = 0;
+    PaymentPriorityQueue::PQNode** batch = scheduledPayments.takeDue(currentTime, limit, processed);
+    if (processed == 0) {
+        delete[] batch;
+        return 0;
+    }
+    int sideCount = processed * 2;
+    int* accounts = new int[sideCount];
+    for (int i = 0; i < processed; i++) {
+        accounts[2 * i] = findUserByAccountNumber(batch[i]->fromAccount);
+        accounts[2 * i + 1] = findUserByAccountNumber(batch[i]->toAccount);
+    }
+    logPaymentsRemoved(batch, processed);
+
+    // Group the sides by account so every account has one running balance.
+    int* sides = new int[sideCount];
+    int grouped = 0;
+    for (int side = 0; side < sideCount; side++) {
+        if (accounts[side] != -1) sides[grouped++] = side;
+    }
+    ScheduledSideOrder order;
+    order.accounts = accounts;
+    sort(sides, sides + grouped, order);
+    int* slots = new int[sideCount];
+    Money* running = new Money[grouped];
+    int slotCount = 0;
+    for (int k = 0; k < grouped; k++) {
+        if (k == 0 || accounts[sides[k]] != accounts[sides[k - 1]]) {
+            running[slotCount++] = users[accounts[sides[k]]]->balance;
+        }
+        slots[sides[k]] = slotCount - 1;
+    }
+
+    // Settle in due order against the running balances, keeping each side's
+    // balance after the payment for its history row.
+    Money* after = new Money[sideCount];
+    bool* executed = new bool[processed];
+    int settled = 0;
+    for (int i = 0; i < processed; i++) {
+        PaymentPriorityQueue::PQNode* payment = batch[i];
+        executed[i] = false;
+        if (accounts[2 * i] == -1 || accounts[2 * i + 1] == -1) continue;
+        Money& fromBalance = running[slots[2 * i]];
+        if (fromBalance < payment->amount) continue;
+        fromBalance -= payment->amount;
+        after[2 * i] = fromBalance;
+        Money& toBalance = running[slots[2 * i + 1]];
+        toBalance += payment->amount;
+        after[2 * i + 1] = toBalance;
+        executed[i] = true;
+        long long lateness = nowMs - static_cast<long long>(payment->executeAt) * 1000;
+        totalLatenessMs += lateness;
+        if (lateness > maxLatenessMs) maxLatenessMs = lateness;
+        if (processed <= LISTED_SCHEDULED_PAYMENTS) {
+            walletNotice("Scheduled payment processed: " + payment->id);
+        }
+        settled++;
+    }
+
+    // One append and one balance change per account.
+    unsigned short* types = new unsigned short[grouped];
+    Money* amounts = new Money[grouped];
+    Money* balances = new Money[grouped];
+    const string** others = new const string*[grouped];
+    int k = 0;
+    while (k < grouped) {
+        int account = accounts[sides[k]];
+        int rows = 0;
+        for (; k < grouped && accounts[sides[k]] == account; k++) {
+            int side = sides[k];
+            PaymentPriorityQueue::PQNode* payment = batch[side / 2];
+            if (!executed[side / 2]) continue;
+            bool sender = side % 2 == 0;
+            types[rows] = sender ? TXN_SCHEDULED_TRANSFER_OUT : TXN_SCHEDULED_TRANSFER_IN;
+            amounts[rows] = payment->amount;
+            balances[rows] = after[side];
+            others[rows] = sender ? &payment->toAccount : &payment->fromAccount;
+            rows++;
+        }
+        if (rows > 0) users[account]->addTransactionRecords(types, amounts, balances, others, rows);
+    }
+    delete[] types;
+    delete[] amounts;
+    delete[] balances;
+    delete[] others;
+    delete[] executed;
+    delete[] after;
+    delete[] running;
+    delete[] slots;
+    delete[] sides;
+
+    if (processed > LISTED_SCHEDULED_PAYMENTS) {
+        walletNotice("Scheduled payments processed: " + to_string(settled) + " of " + to_string(processed) + " due");
+    }
+    for (int i = 0; i < processed; i++) {
+        if (scheduledPayments.reschedule(batch[i])) {
+            logPaymentAdded(batch[i]);
+        } else {
+            delete batch[i];
+        }
+    }
+    delete[] accounts;
+    delete[] batch;
+    scheduledRun += processed;
+    scheduledSettled += settled;
+    scheduledBatches++;
+    commit();
+    return processed;
+}
+
+void BankingSystem::stopScheduler() {
+    if (!scheduler.joinable()) return;
+    {
+        lock_guard<mutex> hold(stateLock);
+        schedulerStopping = true;
+    }
+    paymentsChanged.notify_one();
+    scheduler.join();
+    if (scheduledRun > 0) {
+        walletNotice("Scheduler: " + to_string(scheduledRun) + " payment(s) in " + to_string(scheduledBatches) + " batch(es), " +
+                     to_string(scheduledSettled) + " settled, average lateness " +
+                     to_string(scheduledSettled > 0 ? totalLatenessMs / scheduledSettled : 0) + " ms, max " + to_string(maxLatenessMs) + " ms");
+    }
+}
+
+void BankingSystem::runScheduler() {
+    unique_lock<mutex> hold(stateLock);
+    while (!schedulerStopping) {
+        if (scheduledPayments.isEmpty()) {
+            paymentsChanged.wait(hold);
+            continue;
+        }
+        chrono::system_clock::time_point due = chrono::system_clock::from_time_t(scheduledPayments.peek()->executeAt);
+        if (chrono::system_clock::now() < due) {
+            paymentsChanged.wait_until(hold, due);
+            continue;
+        }
+        if (processScheduledPayments() == SCHEDULER_BATCH_SIZE) {
+            hold.unlock();
+            this_thread::yield();
+            hold.lock();
+        }
+    }
+}
+
+OperationStatus BankingSystem::applyDeposit(User* user, Money amount) {
+    if (amount.cents == 0 || !isValidAmount(amount)) return OP_INVALID_AMOUNT;
+    user->addTransactionRecord(TXN_DEPOSIT, amount, user->balance + amount);
+    user->addSecurityLog(TXN_SECURITY_DEPOSIT, "Amount: " + formatBalance(amount));
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::applyWithdrawal(User* user, Money amount) {
+    if (amount.cents == 0 || !isValidAmount(amount)) return OP_INVALID_AMOUNT;
+    if (amount > user->balance) return OP_INSUFFICIENT_FUNDS;
+    user->addTransactionRecord(TXN_WITHDRAW, amount, user->balance - amount);
+    user->addSecurityLog(TXN_SECURITY_WITHDRAWAL, "Amount: " + formatBalance(amount));
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::applyTransfer(User* from, User* to, Money amount) {
+    TIME_OPERATION(METRIC_TRANSFER);
+    if (from == to) return OP_SAME_ACCOUNT;
+    if (amount.cents == 0 || !isValidAmount(amount)) return OP_INVALID_AMOUNT;
+    if (amount > from->balance) return OP_INSUFFICIENT_FUNDS;
+    unsigned long long transfer = IDGenerator::instance().next();
+    from->addTransactionRecord(TXN_TRANSFER_OUT, amount, from->balance - amount, to->accountNumber, transfer);
+    to->addTransactionRecord(TXN_TRANSFER_IN, amount, to->balance + amount, from->accountNumber, transfer);
+    from->addSecurityLog(TXN_SECURITY_TRANSFER_OUT, "To: " + to->accountNumber + " Amount: " + formatBalance(amount));
+    to->addSecurityLog(TXN_SECURITY_TRANSFER_IN, "From: " + from->accountNumber + " Amount: " + formatBalance(amount));
+    return OP_OK;
+}
+
+// Adds change to the balance undoLast expects to leave on user; false if
+// that would go below zero.
+static bool projectBalance(User** touched, Money* projected, int& count, User* user, Money change) {
+    int i = 0;
+    while (i < count && touched[i] != user) i++;
+    if (i == count) {
+        touched[count] = user;
+        projected[count++] = user->balance;
+    }
+    projected[i] += change;
+    return projected[i].cents >= 0;
+}
+
+OperationStatus BankingSystem::undoLast(User* user, int n) {
+    UndoRing& ring = user->undoRing;
+    if (n <= 0 || n > ring.getCount()) return OP_NOTHING_TO_UNDO;
+    const TransactionTypeTable& table = TransactionTypeTable::instance();
+    long now = static_cast<long>(time(nullptr));
+    User* others[UndoRing::CAPACITY];
+    User* touched[UndoRing::CAPACITY + 1];
+    Money projected[UndoRing::CAPACITY + 1];
+    int touchedCount = 0;
+    for (int k = 0; k < n; k++) {
+        UndoRing::Entry* entry = ring.newest(k);
+        if (now - entry->timestamp > SecurityConfig::UNDO_WINDOW) return OP_UNDO_EXPIRED;
+        if (table.has(entry->type, TXF_SCHEDULED) || !table.has(entry->type, TXF_UNDOABLE)) return OP_NOT_UNDOABLE;
+        Money change = table.has(entry->type, TXF_CREDIT) ? Money() - entry->amount : entry->amount;
+        others[k] = nullptr;
+        if (table.has(entry->type, TXF_TRANSFER)) {
+            int index = findUserByAccountNumber(entry->otherAccount);
+            if (index == -1 || users[index]->undoRing.findTransfer(entry->transfer) == -1) return OP_NOT_UNDOABLE;
+            others[k] = users[index];
+            if (!projectBalance(touched, projected, touchedCount, others[k], Money() - change)) return OP_INSUFFICIENT_FUNDS;
+        }
+        if (!projectBalance(touched, projected, touchedCount, user, change)) return OP_INSUFFICIENT_FUNDS;
+    }
+    unsigned long long removed[UndoRing::CAPACITY];
+    for (int k = 0; k < n; k++) {
+        UndoRing::Entry* entry = ring.newest(k);
+        user->addReversal(*entry, now);
+        removed[k] = entry->id;
+        if (others[k] != nullptr) {
+            UndoRing& otherRing = others[k]->undoRing;
+            int i = otherRing.findTransfer(entry->transfer);
+            unsigned long long otherID = otherRing.at(i)->id;
+            others[k]->addReversal(*otherRing.at(i), now);
+            otherRing.remove(i);
+            others[k]->logUndoRemoved(&otherID, 1);
+        }
+    }
+    ring.dropNewest(n);
+    user->logUndoRemoved(removed, n);
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::transferConcurrent(int fromIndex, int toIndex, Money amount) {
+    if (fromIndex == toIndex) return OP_SAME_ACCOUNT;
+    accountLocks.lockPair(fromIndex, toIndex);
+    OperationStatus status = applyTransfer(users[fromIndex], users[toIndex], amount);
+    accountLocks.unlockPair(fromIndex, toIndex);
+    return status;
+}
+
+Money BankingSystem::totalBalance() const {
+    Money total;
+    for (int i = 0; i < userCount; i++) {
+        total += users[i]->balance;
+    }
+    return total;
+}
+
+OperationStatus BankingSystem::applySchedule(User* user, const string& toAccount, Money amount, long executeAt, string& paymentID,
+                                             char unit, int every, int maxRuns, long long endAt) {
+    if (findUserByAccountNumber(toAccount) == -1) return OP_UNKNOWN_ACCOUNT;
+    if (toAccount == user->accountNumber) return OP_SAME_ACCOUNT;
+    if (amount.cents == 0 || !isValidAmount(amount)) return OP_INVALID_AMOUNT;
+    if (amount > user->balance) return OP_INSUFFICIENT_FUNDS;
+    if (!PaymentPriorityQueue::isValidRecurUnit(unit) || (unit != PaymentPriorityQueue::RECUR_NONE && every <= 0) ||
+        maxRuns < 0 || (endAt != 0 && endAt < executeAt)) {
+        return OP_INVALID_SCHEDULE;
+    }
+    // IDs only repeat if the clock stepped back across a restart.
+    do {
+        paymentID = "PAY" + to_string(IDGenerator::instance().next());
+    } while (scheduledPayments.find(paymentID) != nullptr);
+    PaymentPriorityQueue::PQNode* payment = scheduledPayments.enqueue(paymentID, executeAt, user->accountNumber, toAccount, amount);
+    if (unit != PaymentPriorityQueue::RECUR_NONE) {
+        payment->unit = unit;
+        payment->every = every;
+        payment->maxRuns = maxRuns;
+        payment->endAt = endAt;
+    }
+    if (scheduledPayments.peek() == payment) paymentsChanged.notify_one();
+    logPaymentAdded(payment);
+    user->addSecurityLog("PAYMENT_SCHEDULED", "To: " + toAccount);
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::applyCancel(User* user, const string& paymentID) {
+    PaymentPriorityQueue::PQNode* match = scheduledPayments.find(paymentID);
+    if (match == nullptr || match->fromAccount != user->accountNumber) return OP_UNKNOWN_PAYMENT;
+    delete scheduledPayments.remove(paymentID);
+    logPaymentRemoved(paymentID);
+    user->addSecurityLog("PAYMENT_CANCELLED", "Payment ID: " + paymentID);
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::authenticate(const string& userID, const string& password, User*& user) {
+    int index = findUserByUserID(userID);
+    if (index == -1) return OP_BAD_CREDENTIALS;
+    user = users[index];
+    if (!user->verifyPassword(password)) {
+        return user->isLocked ? OP_ACCOUNT_LOCKED : OP_BAD_CREDENTIALS;
+    }
+    user->addSecurityLog("LOGIN_SUCCESS");
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::checkPIN(User* user, const string& pin) {
+    if (user->verifyPIN(pin)) return OP_OK;
+    if (user->isLocked) {
+        user->addSecurityLog("ACCOUNT_LOCKED", "Too many failed PIN attempts");
+        return OP_ACCOUNT_LOCKED;
+    }
+    user->addSecurityLog("FAILED_PIN_ATTEMPT", "Attempts: " + to_string(user->loginAttempts));
+    return OP_BAD_PIN;
+}
+
+OperationStatus BankingSystem::openAccount(const string& name, const string& email, const string& phone, const string& address,
+                                           const string& accountType, Money initialBalance, const string& password, const string& pin,
+                                           User*& user) {
+    User rules;
+    if (!isValidName(name) || !isValidEmail(email) || !isValidPhone(phone) || address.empty() || address.length() > 100 ||
+        (accountType != "Savings" && accountType != "Current") || !isValidAmount(initialBalance) ||
+        !isValidPassword(password) || rules.isWeakPassword(password) || !isValidPIN(pin) || rules.isWeakPIN(pin)) {
+        return OP_INVALID_DETAILS;
+    }
+    if (!isEmailUnique(email)) return OP_EMAIL_TAKEN;
+    user = new User(name, generateUserID(), password, pin, email, phone, address, accountType, initialBalance);
+    while (findUserByAccountNumber(user->accountNumber) != -1) {
+        user->accountNumber = user->generateAccountNumber();
+    }
+    if (userCount >= capacity) {
+        resizeArray();
+    }
+    users[userCount] = user;
+    indexUser(userCount);
+    userCount++;
+    user->journal = &journal;
+    logSystemCounters();
+    logNewUser(user);
+    user->addTransactionRecord(TXN_ACCOUNT_CREATION, initialBalance, initialBalance);
+    user->addSecurityLog("ACCOUNT_CREATED");
+    return OP_OK;
+}
+
+OperationStatus BankingSystem::changeEmail(User* user, const string& email) {
+    if (email != user->email && !isEmailUnique(email)) return OP_EMAIL_TAKEN;
+    int index = findUserByUserID(user->userID);
+    emailIndex.remove(user->email, index, users);
+    bool updated = user->setEmail(email);
+    emailIndex.insert(index, users);
+    return updated ? OP_OK : OP_INVALID_DETAILS;
+}
+
+OperationStatus BankingSystem::applyBatchOperation(const BatchOperation& op) {
+    int from = findUserByAccountNumber(op.fromAccount);
+    if (from == -1) return OP_UNKNOWN_ACCOUNT;
+    if (op.kind == 'D') return applyDeposit(users[from], op.amount);
+    if (op.kind == 'W') return applyWithdrawal(users[from], op.amount);
+    int to = findUserByAccountNumber(op.toAccount);
+    if (to == -1) return OP_UNKNOWN_ACCOUNT;
+    return applyTransfer(users[from], users[to], op.amount);
+}
+
+bool BankingSystem::parseBatchLine(const string& line, BatchOperation& op) {
+    string fields[4];
+    int n = 0;
+    size_t start = 0;
+    while (true) {
+        if (n == 4) return false;
+        size_t comma = line.find(',', start);
+        string field = line.substr(start, comma == string::npos ? string::npos : comma - start);
+        size_t first = field.find_first_not_of(" \t");
+        size_t last = field.find_last_not_of(" \t");
+        fields[n++] = first == string::npos ? "" : field.substr(first, last - first + 1);
+        if (comma == string::npos) break;
+        start = comma + 1;
+    }
+    if (fields[0] == "DEPOSIT" || fields[0] == "D") op.kind = 'D';
+    else if (fields[0] == "WITHDRAW" || fields[0] == "W") op.kind = 'W';
+    else if (fields[0] == "TRANSFER" || fields[0] == "T") op.kind = 'T';
+    else return false;
+    if (n != (op.kind == 'T' ? 4 : 3)) return false;
+    op.fromAccount = fields[1];
+    op.toAccount = op.kind == 'T' ? fields[2] : "";
+    return !op.fromAccount.empty() && Money::parse(fields[n - 1].c_str(), op.amount);
+}
+
+bool BankingSystem::runBatch(const string& fileName, BatchSummary& summary) {
+    MappedFile file;
+    if (!file.open(fileName)) return false;
+    summary.opened = true;
+    journal.sync();
+    journal.suspended = true;
+    long long* outcomes = summary.outcomes;
+    long long& operations = summary.operations;
+    long long& malformed = summary.malformed;
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    BatchOperation op;
+    if (file.size >= 8 && memcmp(file.data, "SWBATCH1", 8) == 0) {
+        SnapshotReader in(file.data + 8, file.size - 8);
+        while (in.pos < in.size) {
+            op.kind = static_cast<char>(in.getU8());
+            op.fromAccount = in.getString();
+            op.toAccount = in.getString();
+            op.amount = in.getMoney();
+            if (!in.ok || (op.kind != 'D' && op.kind != 'W' && op.kind != 'T')) {
+                reportBatchProblem(summary, "operation", operations + 1, "malformed record, rest of file skipped");
+                malformed++;
+                break;
+            }
+            operations++;
+            OperationStatus status = applyBatchOperation(op);
+            outcomes[status]++;
+            if (status != OP_OK) reportBatchProblem(summary, "operation", operations, operationStatusText(status));
+        }
+    } else {
+        TextCursor in(file.data, file.size);
+        string line;
+        long long lineNumber = 0;
+        while (in.readLine(line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#') continue;
+            if (!parseBatchLine(line, op)) {
+                malformed++;
+                reportBatchProblem(summary, "line", lineNumber, "malformed");
+                continue;
+            }
+            operations++;
+            OperationStatus status = applyBatchOperation(op);
+            outcomes[status]++;
+            if (status != OP_OK) reportBatchProblem(summary, "line", lineNumber, operationStatusText(status));
+        }
+    }
+    chrono::steady_clock::time_point applied = chrono::steady_clock::now();
+    journal.suspended = false;
+    bool committed = saveToFile();
+    if (!committed) journal.markUnsaved();
+    chrono::steady_clock::time_point finished = chrono::steady_clock::now();
+
+    summary.applySeconds = chrono::duration<double>(applied - started).count();
+    summary.totalSeconds = chrono::duration<double>(finished - started).count();
+    return committed;
+}
+
+bool BankingSystem::saveToFile() {
+    TIME_OPERATION(METRIC_SAVE);
+    finishBackgroundCheckpoint(true);
+    long long generation = journal.generation + 1;
+    string* written = nullptr;
+    int segments = planCheckpoint(generation, written);
+    if (!writeCheckpointFiles(generation, written, segments)) {
+        discardCheckpointFiles(written, segments);
+        delete[] written;
+        walletNotice("Error saving data!");
+        journal.sync();
+        return false;
+    }
+    adoptCheckpointFiles(written, segments, true);
+    delete[] written;
+    journal.fileName = journalFileName;
+    journal.reset(generation);
+    ::unlink(previousJournalFileName().c_str());
+    return true;
+}
+
+void BankingSystem::startBackgroundCheckpoint() {
+    finishBackgroundCheckpoint(false);
+    if (checkpointWriter.joinable()) return;
+    if (!journal.sync() || ::rename(journalFileName.c_str(), previousJournalFileName().c_str()) != 0) {
+        saveToFile();
+        return;
+    }
+    long long generation = journal.generation + 1;
+    journal.fileName = journalFileName;
+    journal.reset(generation);
+    string* written = nullptr;
+    int segments = planCheckpoint(generation, written);
+    SnapshotWriter* output = new SnapshotWriter[segments + 1];
+    for (int segment = 0; segment < segments; segment++) {
+        if (written[segment].empty()) continue;
+        serializeSegment(segment, generation, output[segment]);
+        setSegmentDirty(segment, false);
+    }
+    serializeManifest(generation, written, segments, output[segments]);
+    checkpointSegments = written;
+    checkpointSegmentCount = segments;
+    checkpointOutput = output;
+    checkpointOk = false;
+    checkpointDone = false;
+    checkpointWriter = thread(&BankingSystem::runCheckpointWriter, this);
+}
+
+void BankingSystem::runCheckpointWriter() {
+    checkpointOk = writeCheckpointOutput(checkpointSegments, checkpointSegmentCount, checkpointOutput);
+    checkpointDone = true;
+}
+
+void BankingSystem::finishBackgroundCheckpoint(bool wait) {
+    if (!checkpointWriter.joinable()) return;
+    if (!wait && !checkpointDone) return;
+    checkpointWriter.join();
+    string* written = checkpointSegments;
+    int segments = checkpointSegmentCount;
+    delete[] checkpointOutput;
+    checkpointOutput = nullptr;
+    checkpointSegments = nullptr;
+    checkpointSegmentCount = 0;
+    if (checkpointOk) {
+        adoptCheckpointFiles(written, segments, false);
+        ::unlink(previousJournalFileName().c_str());
+        delete[] written;
+        return;
+    }
+    discardCheckpointFiles(written, segments);
+    for (int segment = 0; segment < segments; segment++) {
+        if (!written[segment].empty()) setSegmentDirty(segment, true);
+    }
+    delete[] written;
+    walletNotice("Warning: background save failed, saving again.");
+    saveToFile();
+}
+
+void BankingSystem::setSegmentDirty(int segment, bool dirty) {
+    int last = (segment + 1) * SEGMENT_USERS < userCount ? (segment + 1) * SEGMENT_USERS : userCount;
+    for (int i = segment * SEGMENT_USERS; i < last; i++) {
+        users[i]->dirty = dirty;
+    }
+}
+
+int BankingSystem::planCheckpoint(long long generation, string*& written) {
+    int segments = segmentCountFor(userCount);
+    if (segments > segmentCapacity) {
+        string* grown = new string[segments];
+        for (int i = 0; i < segmentCapacity; i++) {
+            grown[i] = segmentFiles[i];
+        }
+        delete[] segmentFiles;
+        segmentFiles = grown;
+        segmentCapacity = segments;
+    }
+    written = new string[segments + 1];
+    for (int segment = 0; segment < segments; segment++) {
+        int first = segment * SEGMENT_USERS;
+        int last = first + SEGMENT_USERS < userCount ? first + SEGMENT_USERS : userCount;
+        bool changed = segmentFiles[segment].empty();
+        for (int i = first; i < last && !changed; i++) {
+            changed = users[i]->dirty;
+        }
+        if (changed) written[segment] = segmentFileName(segment, generation);
+    }
+    return segments;
+}
+
+void BankingSystem::serializeSegment(int segment, long long generation, SnapshotWriter& out) {
+    int first = segment * SEGMENT_USERS;
+    int last = first + SEGMENT_USERS < userCount ? first + SEGMENT_USERS : userCount;
+    out.begin();
+    out.putTypeTable();
+    out.putU32(0);
+    for (int i = first; i < last; i++) {
+        users[i]->saveBinary(out);
+    }
+    out.finish(last - first, 0, nextUserID, invalidIDAttempts, generation);
+}
+
+void BankingSystem::serializeManifest(long long generation, const string* written, int segments, SnapshotWriter& out) {
+    out.begin();
+    out.putTypeTable();
+    out.putU32(static_cast<unsigned long>(segments));
+    for (int segment = 0; segment < segments; segment++) {
+        int first = segment * SEGMENT_USERS;
+        out.putString(written[segment].empty() ? segmentFiles[segment] : written[segment]);
+        out.putI64(first + SEGMENT_USERS < userCount ? SEGMENT_USERS : userCount - first);
+    }
+    putPayments(out);
+    out.finish(userCount, scheduledPayments.size(), nextUserID, invalidIDAttempts, generation);
+}
+
+bool BankingSystem::writeCheckpointFiles(long long generation, const string* written, int segments) {
+    string directory = snapshotDirectory(snapshotFileName);
+    for (int segment = 0; segment < segments; segment++) {
+        if (written[segment].empty()) continue;
+        SnapshotWriter out;
+        serializeSegment(segment, generation, out);
+        if (!writeSnapshotFile(directory + written[segment], out)) return false;
+    }
+    SnapshotWriter out;
+    serializeManifest(generation, written, segments, out);
+    return writeSnapshotFile(snapshotFileName, out) && syncDirectory(directory);
+}
+
+bool BankingSystem::writeCheckpointOutput(const string* written, int segments, const SnapshotWriter* output) const {
+    string directory = snapshotDirectory(snapshotFileName);
+    for (int segment = 0; segment < segments; segment++) {
+        if (written[segment].empty()) continue;
+        if (!writeSnapshotFile(directory + written[segment], output[segment])) return false;
+    }
+    return writeSnapshotFile(snapshotFileName, output[segments]) && syncDirectory(directory);
+}
+
+void BankingSystem::adoptCheckpointFiles(const string* written, int segments, bool clearDirty) {
+    string directory = snapshotDirectory(snapshotFileName);
+    for (int segment = 0; segment < segments; segment++) {
+        if (written[segment].empty()) continue;
+        if (!segmentFiles[segment].empty()) {
+            ::unlink((directory + segmentFiles[segment]).c_str());
+        }
+        segmentFiles[segment] = written[segment];
+        if (clearDirty) setSegmentDirty(segment, false);
+    }
+}
+
+void BankingSystem::discardCheckpointFiles(const string* written, int segments) {
+    string directory = snapshotDirectory(snapshotFileName);
+    for (int segment = 0; segment < segments; segment++) {
+        if (!written[segment].empty()) ::unlink((directory + written[segment]).c_str());
+    }
+}
+
+bool BankingSystem::saveBinaryFile(const string& fileName, long long generation) {
+    SnapshotWriter out;
+    out.begin();
+    out.putTypeTable();
+    out.putU32(0);
+    for (int i = 0; i < userCount; i++) {
+        users[i]->saveBinary(out);
+    }
+    putPayments(out);
+    out.finish(userCount, scheduledPayments.size(), nextUserID, invalidIDAttempts, generation);
+    return writeSnapshotFile(fileName, out) && syncDirectory(snapshotDirectory(fileName));
+}
+
+void BankingSystem::putPayments(SnapshotWriter& out) {
+    int paymentCount = scheduledPayments.size();
+    PaymentPriorityQueue::PQNode** ordered = new PaymentPriorityQueue::PQNode*[paymentCount + 1];
+    for (int i = 0; i < paymentCount; i++) {
+        ordered[i] = scheduledPayments.at(i);
+    }
+    PaymentPriorityQueue::sortByExecution(ordered, paymentCount);
+    for (int i = 0; i < paymentCount; i++) {
+        out.putString(ordered[i]->id);
+        out.putI64(ordered[i]->executeAt);
+        out.putString(ordered[i]->fromAccount);
+        out.putString(ordered[i]->toAccount);
+        out.putMoney(ordered[i]->amount);
+        out.putU8(static_cast<unsigned char>(ordered[i]->unit));
+        if (ordered[i]->recurring()) {
+            out.putU32(static_cast<unsigned long>(ordered[i]->every));
+            out.putU32(static_cast<unsigned long>(ordered[i]->maxRuns));
+            out.putI64(ordered[i]->endAt);
+            out.putI64(ordered[i]->anchor);
+            out.putU32(static_cast<unsigned long>(ordered[i]->fired));
+        }
+    }
+    delete[] ordered;
+}
+
+bool BankingSystem::writeSnapshotFile(const string& fileName, const SnapshotWriter& out) {
+    string temporary = fileName + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) return false;
+    size_t written = 0;
+    while (written < out.buffer.length()) {
+        ssize_t n = ::write(fd, out.buffer.data() + written, out.buffer.length() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    bool ok = written == out.buffer.length() && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || ::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool BankingSystem::syncDirectory(const string& directory) {
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool BankingSystem::saveTextFile(const string& fileName, long long generation) {
+    ofstream file(fileName.c_str());
+    if (!file.is_open()) {
+        return false;
+    } 
+    file << userCount << endl;
+    file << nextUserID << endl;
+    file << invalidIDAttempts << endl;
+    for (int i = 0; i < userCount; i++) {
+        users[i]->saveToFile(file);
+    }
+    int paymentCount = scheduledPayments.size();
+    PaymentPriorityQueue::PQNode** ordered = new PaymentPriorityQueue::PQNode*[paymentCount + 1];
+    for (int i = 0; i < paymentCount; i++) {
+        ordered[i] = scheduledPayments.at(i);
+    }
+    PaymentPriorityQueue::sortByExecution(ordered, paymentCount);
+    file << paymentCount << endl;
+    for (int i = 0; i < paymentCount; i++) {
+        PaymentPriorityQueue::PQNode* current = ordered[i];
+        file << current->id << endl;
+        file << current->executeAt;
+        if (current->recurring()) {
+            file << ' ' << current->unit << ' ' << current->every << ' ' << current->maxRuns << ' '
+                 << current->endAt << ' ' << current->anchor << ' ' << current->fired;
+        }
+        file << endl;
+        file << current->fromAccount << endl;
+        file << current->toAccount << endl;
+        file << current->amount.format() << endl;
+    }
+    delete[] ordered;
+    file << "JOURNAL " << generation << endl;
+    file.close();
+    return !file.fail();
+}
+
+void BankingSystem::commit() {
+    TIME_OPERATION(METRIC_COMMIT);
+    bool journalled = journal.isOpen() && journal.commit();
+    lock_guard<mutex> guard(commitLock);
+    if (!journalled || journal.bytes >= JOURNAL_CHECKPOINT_BYTES) {
+        accountLocks.lockAll();
+        if (!journalled) {
+            saveToFile();
+        } else {
+            startBackgroundCheckpoint();
+        }
+        accountLocks.unlockAll();
+    } else {
+        finishBackgroundCheckpoint(false);
+    }
+}
+
+void BankingSystem::logPaymentAdded(PaymentPriorityQueue::PQNode* payment) {
+    string fields[] = {"Q+", payment->id, to_string(payment->executeAt), payment->fromAccount, payment->toAccount,
+                       payment->amount.format(), string(1, payment->unit), to_string(payment->every),
+                       to_string(payment->maxRuns), to_string(payment->endAt), to_string(payment->anchor),
+                       to_string(payment->fired)};
+    journal.append(fields, payment->recurring() ? 12 : 6);
+}
+
+void BankingSystem::logPaymentsRemoved(PaymentPriorityQueue::PQNode** payments, int n) {
+    string fields[PAYMENT_IDS_PER_RECORD + 1];
+    fields[0] = "Q-";
+    for (int start = 0; start < n; start += PAYMENT_IDS_PER_RECORD) {
+        int k = 0;
+        while (k < PAYMENT_IDS_PER_RECORD && start + k < n) {
+            fields[1 + k] = payments[start + k]->id;
+            k++;
+        }
+        journal.append(fields, 1 + k);
+    }
+}
+
+void BankingSystem::applyJournalRecord(string* f, int n) {
+    if (f[0] == "S" && n == 3) {
+        nextUserID = atoi(f[1].c_str());
+        invalidIDAttempts = atoi(f[2].c_str());
+    } else if (f[0] == "U" && n == 12) {
+        User* user = new User();
+        user->name = f[1];
+        user->userID = f[2];
+        user->password = f[3];
+        user->pin = f[4];
+        user->accountNumber = f[5];
+        user->email = f[6];
+        user->phone = f[7];
+        user->address = f[8];
+        user->accountType = f[9];
+        user->balance = Money::parse(f[10]);
+        user->dateCreated = f[11];
+        if (userCount >= capacity) {
+            resizeArray();
+        }
+        users[userCount] = user;
+        indexUser(userCount);
+        userCount++;
+    } else if (f[0] == "Q+" && (n == 6 || n == 12)) {
+        PaymentPriorityQueue::PQNode* payment = scheduledPayments.enqueue(f[1], atol(f[2].c_str()), f[3], f[4], Money::parse(f[5]));
+        if (n == 12 && f[6].length() == 1 && PaymentPriorityQueue::isValidRecurUnit(f[6][0])) {
+            payment->unit = f[6][0];
+            payment->every = atoi(f[7].c_str());
+            payment->maxRuns = atoi(f[8].c_str());
+            payment->endAt = atoll(f[9].c_str());
+            payment->anchor = atoll(f[10].c_str());
+            payment->fired = atoi(f[11].c_str());
+        }
+    } else if (f[0] == "Q-" && n >= 2) {
+        for (int i = 1; i < n; i++) {
+            delete scheduledPayments.remove(f[i]);
+        }
+    } else if (n >= 2) {
+        int index = findUserByAccountNumber(f[1]);
+        if (index == -1) return;
+        User* user = users[index];
+        user->dirty = true;
+        if (f[0] == "T" && (n == 10 || n == 11)) {
+            Money amount = Money::parse(f[4]);
+            Money balanceAfter = Money::parse(f[5]);
+            long timestamp = atol(f[7].c_str());
+            user->balance = balanceAfter;
+            unsigned short type = TransactionTypeTable::instance().intern(f[3]);
+            user->transactions.addTransaction(f[2], type, amount, balanceAfter, f[6], timestamp);
+            if (f[8] == "1") {
+                user->undoRing.push(TransactionHistory::idValue(f[2], type), type, amount, Money::parse(f[9]), balanceAfter, f[6], timestamp,
+                                    n == 11 ? strtoull(f[10].c_str(), nullptr, 10) : 0);
+            }
+        } else if (f[0] == "P") {
+            if (n == 2) user->undoRing.dropNewest();
+            for (int i = 2; i < n; i++) {
+                user->undoRing.remove(user->undoRing.find(strtoull(f[i].c_str(), nullptr, 10)));
+            }
+        } else if (f[0] == "A" && n == 5) {
+            user->loginAttempts = atoi(f[2].c_str());
+            user->lastLoginAttempt = atol(f[3].c_str());
+            user->isLocked = f[4] == "1";
+        } else if (f[0] == "F" && n == 4) {
+            if (f[2] == "email") {
+                emailIndex.remove(user->email, index, users);
+                user->email = f[3];
+                emailIndex.insert(index, users);
+            }
+            else if (f[2] == "phone") user->phone = f[3];
+            else if (f[2] == "address") user->address = f[3];
+            else if (f[2] == "password") user->password = f[3];
+            else if (f[2] == "pin") user->pin = f[3];
+        }
+    }
+}
+
+void BankingSystem::replayJournal() {
+    long long validBytes = 0;
+    bool chained = replayJournalFile(previousJournalFileName(), journal.generation, validBytes);
+    if (chained) {
+        journal.generation++;
+        validBytes = 0;
+    }
+    replayJournalFile(journalFileName, journal.generation, validBytes);
+    if (!journal.open(journalFileName, journal.generation, validBytes)) {
+        walletNotice("Warning: journal unavailable, every change will rewrite " + dataFileName);
+    }
+    if (chained) {
+        saveToFile();
+    } else {
+        ::unlink(previousJournalFileName().c_str());
+    }
+}
+
+bool BankingSystem::replayJournalFile(const string& fileName, long long generation, long long& validBytes) {
+    ifstream file(fileName.c_str());
+    if (!file.is_open()) return false;
+    string line;
+    string* fields = new string[MAX_JOURNAL_FIELDS];
+    bool first = true;
+    long long offset = 0;
+    while (getline(file, line)) {
+        if (file.eof()) break;
+        int n = Journal::parse(line, fields, MAX_JOURNAL_FIELDS);
+        if (n < 1) break;
+        if (first) {
+            if (n != 2 || fields[0] != "JOURNAL" || atoll(fields[1].c_str()) != generation) break;
+            first = false;
+        } else {
+            applyJournalRecord(fields, n);
+        }
+        offset += static_cast<long long>(line.length()) + 1;
+        validBytes = offset;
+    }
+    delete[] fields;
+    file.close();
+    return !first;
+}
+
+void BankingSystem::loadFromFile() {
+    TIME_OPERATION(METRIC_LOAD);
+    ifstream probe(snapshotFileName.c_str());
+    if (probe.is_open()) {
+        probe.close();
+        if (loadBinaryFile(snapshotFileName)) {
+            removeStaleSnapshotFiles();
+            return;
+        }
+        walletNotice("Warning: " + snapshotFileName + " is damaged, falling back to " + dataFileName);
+    }
+    loadTextFile(dataFileName);
+}
+
+void BankingSystem::removeStaleSnapshotFiles() {
+    string directory = snapshotDirectory(snapshotFileName);
+    string base = snapshotFileName.substr(directory.size());
+    int segments = segmentCountFor(userCount);
+    bool known = segments > 0 && segments <= segmentCapacity;
+    for (int segment = 0; segment < segments && known; segment++) {
+        known = !segmentFiles[segment].empty();
+    }
+    DIR* listing = ::opendir(directory.empty() ? "." : directory.c_str());
+    if (listing == nullptr) return;
+    string segmentPrefix = base + ".seg";
+    while (dirent* entry = ::readdir(listing)) {
+        string name = entry->d_name;
+        bool stale = name == base + ".tmp";
+        if (!stale && known && name.compare(0, segmentPrefix.size(), segmentPrefix) == 0) {
+            stale = true;
+            for (int segment = 0; segment < segments && stale; segment++) {
+                stale = name != segmentFiles[segment];
+            }
+        }
+        if (stale) ::unlink((directory + name).c_str());
+    }
+    ::closedir(listing);
+}
+
+bool BankingSystem::loadBinaryImage(const char* image, size_t size, const string& directory) {
+    SnapshotHeader header;
+    if (!header.parse(image, size)) return false;
+    long long loadedUserCount = header.userCount;
+    long long paymentCount = header.paymentCount;
+    if (loadedUserCount > MAX_LOADED_USERS) return false;
+
+    if (loadedUserCount >= capacity) {
+        delete[] users;
+        capacity = static_cast<int>(loadedUserCount) + 1;
+        users = new User*[capacity];
+        for (int i = 0; i < capacity; i++) {
+            users[i] = nullptr;
+        }
+    }
+    SnapshotReader in(image + SnapshotWriter::HEADER_SIZE, size - SnapshotWriter::HEADER_SIZE);
+    in.version = header.version;
+    in.getTypeTable();
+    int loaded = 0;
+    unsigned long segments = 0;
+    string* names = nullptr;
+    bool standardLayout = true;
+    if (in.version >= 5) {
+        segments = in.getU32();
+        if (segments > static_cast<unsigned long>(loadedUserCount)) in.ok = false;
+        names = new string[in.ok ? segments + 1 : 1];
+        for (unsigned long segment = 0; segment < segments && in.ok; segment++) {
+            names[segment] = in.getString();
+            long long count = in.getI64();
+            if (!in.ok || count < 0 || loaded + count > loadedUserCount ||
+                !loadSegmentFile(directory + names[segment], loaded, static_cast<int>(count))) {
+                in.ok = false;
+                break;
+            }
+            if (loaded != static_cast<int>(segment) * SEGMENT_USERS ||
+                count != (loadedUserCount - loaded < SEGMENT_USERS ? loadedUserCount - loaded : SEGMENT_USERS)) {
+                standardLayout = false;
+            }
+            loaded += static_cast<int>(count);
+        }
+    }
+    for (int i = loaded; i < loadedUserCount && in.ok; i++) {
+        users[i] = new User();
+        userCount = i + 1;
+        if (!users[i]->loadBinary(in)) break;
+    }
+    for (long long i = 0; i < paymentCount && in.ok; i++) {
+        string id = in.getString();
+        long executeAt = static_cast<long>(in.getI64());
+        string fromAccount = in.getString();
+        string toAccount = in.getString();
+        Money amount = in.getMoney();
+        char unit = PaymentPriorityQueue::RECUR_NONE;
+        if (in.version >= 4) {
+            unit = static_cast<char>(in.getU8());
+            if (!PaymentPriorityQueue::isValidRecurUnit(unit)) in.ok = false;
+        }
+        if (!in.ok) break;
+        PaymentPriorityQueue::PQNode* payment = scheduledPayments.enqueue(id, executeAt, fromAccount, toAccount, amount);
+        if (unit != PaymentPriorityQueue::RECUR_NONE) {
+            payment->unit = unit;
+            payment->every = static_cast<int>(in.getU32());
+            payment->maxRuns = static_cast<int>(in.getU32());
+            payment->endAt = in.getI64();
+            payment->anchor = in.getI64();
+            payment->fired = static_cast<int>(in.getU32());
+        }
+    }
+    if (!in.ok) {
+        delete[] names;
+        clearUsers();
+        scheduledPayments.clear();
+        return false;
+    }
+    if (loaded == loadedUserCount && standardLayout && segments > 0) {
+        delete[] segmentFiles;
+        segmentFiles = names;
+        segmentCapacity = static_cast<int>(segments) + 1;
+    } else {
+        delete[] names;
+        for (int i = 0; i < userCount; i++) {
+            users[i]->dirty = true;
+        }
+    }
+    nextUserID = static_cast<int>(header.nextUserID);
+    invalidIDAttempts = static_cast<int>(header.invalidIDAttempts);
+    journal.generation = header.generation;
+    rebuildIndexes();
+    return true;
+}
+
+bool BankingSystem::loadSegmentFile(const string& fileName, int first, int count) {
+    MappedFile file;
+    SnapshotHeader header;
+    if (!file.open(fileName) || !header.parse(file.data, file.size)) return false;
+    if (header.version < 5 || header.userCount != count || header.paymentCount != 0) return false;
+    SnapshotReader in(file.data + SnapshotWriter::HEADER_SIZE, file.size - SnapshotWriter::HEADER_SIZE);
+    in.version = header.version;
+    in.getTypeTable();
+    if (in.getU32() != 0) return false;
+    for (int i = 0; i < count; i++) {
+        users[first + i] = new User();
+        userCount = first + i + 1;
+        if (!users[first + i]->loadBinary(in)) return false;
+        users[first + i]->dirty = false;
+    }
+    return in.ok;
+}
+
+void BankingSystem::loadTextFile(const string& fileName) {
+    MappedFile file;
+    if (!file.open(fileName)) {
+        return;
+    }
+    TextCursor in(file.data, file.size);
+    int loadedUserCount;
+    if (!in.readInt(loadedUserCount)) {
+        return;
+    }
+    if (loadedUserCount < 0 || loadedUserCount > MAX_LOADED_USERS) {
+        return;
+    }
+    if (!in.readInt(nextUserID) || !in.readInt(invalidIDAttempts)) {
+        return;
+    }
+    in.skipLineEnd();
+    if (loadedUserCount >= capacity) {
+        delete[] users;
+        capacity = loadedUserCount + 1;
+        users = new User*[capacity];
+        for (int i = 0; i < capacity; i++) {
+            users[i] = nullptr;
+        }
+    }
+    for (int i = 0; i < loadedUserCount; i++) {
+        if (in.atEnd()) break;
+        users[i] = new User();
+        userCount = i + 1;
+        if (!users[i]->loadFromText(in)) break;
+    }
+    rebuildIndexes();
+    int scheduledCount = 0;
+    if (in.readInt(scheduledCount)) {
+        in.skipLineEnd();
+        string id, timing, fromAccount, toAccount;
+        for (int i = 0; i < scheduledCount; i++) {
+            long long executeAt, endAt, anchor;
+            char unit;
+            int every, maxRuns, fired;
+            Money amount;
+            if (!in.readLine(id) || !in.readLine(timing)) break;
+            int timingFields = sscanf(timing.c_str(), "%lld %c %d %d %lld %lld %d", &executeAt, &unit, &every, &maxRuns, &endAt, &anchor, &fired);
+            if (timingFields != 1 && (timingFields != 7 || !PaymentPriorityQueue::isValidRecurUnit(unit))) break;
+            if (!in.readLine(fromAccount) || !in.readLine(toAccount)) break;
+            if (!in.readMoney(amount)) break;
+            in.skipLineEnd();
+            PaymentPriorityQueue::PQNode* payment = scheduledPayments.enqueue(id, static_cast<long>(executeAt), fromAccount, toAccount, amount);
+            if (timingFields == 7) {
+                payment->unit = unit;
+                payment->every = every;
+                payment->maxRuns = maxRuns;
+                payment->endAt = endAt;
+                payment->anchor = anchor;
+                payment->fired = fired;
+            }
+        }
+    }
+    string tag;
+    long long generation = 0;
+    if (in.readWord(tag) && tag == "JOURNAL" && in.readLong(generation)) {
+        journal.generation = generation;
+    }
+}
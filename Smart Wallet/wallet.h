@@ -0,0 +1,2033 @@
+// Core of the Smart Wallet: accounts, transaction history, scheduled
+// payments, the journal and snapshots, and BankingSystem tying them
+// together. Nothing in here reads from cin or writes to cout; operations
+// report through their return values (mostly OperationStatus) and the
+// few unprompted messages go through walletNotice.
+#ifndef SMART_WALLET_H
+#define SMART_WALLET_H
+
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <cctype>
+#include <fstream>
+#include <cmath>
+#include <new>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <sys/types.h>
+#include <unistd.h>
+
+class SecurityConfig {
+public:
+    static const int MAX_LOGIN_ATTEMPTS = 3;
+    static const int ACCOUNT_LOCKOUT_TIME = 10;
+    static const int UNDO_WINDOW = 60;
+    // Undoable operations kept per account.
+    static const int UNDO_DEPTH = 8;
+};
+
+inline unsigned long long hashString(const std::string& key) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (size_t i = 0; i < key.length(); i++) {
+        h ^= static_cast<unsigned char>(key[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Amount of money in integer cents. Balances, transaction amounts and
+// scheduled payments all use it, so ledger arithmetic is exact and
+// formatting needs no floating-point rounding.
+class Money {
+public:
+    // Longest formatted amount: sign, 17 digits, point and two decimals.
+    static const int FORMATTED_SIZE = 24;
+    long long cents;
+
+    Money() : cents(0) {}
+    explicit Money(long long c) : cents(c) {}
+
+    static Money fromDouble(double value) {
+        return Money(llround(value * 100));
+    }
+
+    // Plain decimals ("12", "-3.5", "1000.25") are read exactly, rounding
+    // half up past the second decimal place. Anything else strtod accepts
+    // (older files wrote doubles such as "1.23457e+06") is rounded to the
+    // nearest cent.
+    static bool parse(const char* text, Money& out) {
+        const char* p = text;
+        bool negative = false;
+        if (*p == '-' || *p == '+') {
+            negative = *p == '-';
+            p++;
+        }
+        long long whole = 0;
+        int digits = 0;
+        while (isdigit(static_cast<unsigned char>(*p)) && digits < 16) {
+            whole = whole * 10 + (*p - '0');
+            digits++;
+            p++;
+        }
+        long long fraction = 0;
+        int fractionDigits = 0;
+        bool roundUp = false;
+        if (*p == '.') {
+            p++;
+            while (isdigit(static_cast<unsigned char>(*p))) {
+                if (fractionDigits < 2) fraction = fraction * 10 + (*p - '0');
+                else if (fractionDigits == 2) roundUp = *p >= '5';
+                fractionDigits++;
+                p++;
+            }
+        }
+        if (*p == '\0' && digits + fractionDigits > 0) {
+            if (fractionDigits == 1) fraction *= 10;
+            long long cents = whole * 100 + fraction + (roundUp ? 1 : 0);
+            out = Money(negative ? -cents : cents);
+            return true;
+        }
+        char* end;
+        double value = strtod(text, &end);
+        if (end == text || *end != '\0') return false;
+        out = fromDouble(value);
+        return true;
+    }
+
+    static Money parse(const std::string& text) {
+        Money value;
+        parse(text.c_str(), value);
+        return value;
+    }
+
+    std::string format() const {
+        char buf[FORMATTED_SIZE];
+        return std::string(buf, formatTo(buf));
+    }
+
+    // format() without the string: writes the text (not terminated) into
+    // out, which must hold FORMATTED_SIZE characters, and returns its length.
+    size_t formatTo(char* out) const {
+        char buf[FORMATTED_SIZE];
+        int i = sizeof(buf);
+        unsigned long long rest = cents < 0 ? 0ULL - static_cast<unsigned long long>(cents) : static_cast<unsigned long long>(cents);
+        buf[--i] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+        buf[--i] = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+        buf[--i] = '.';
+        do {
+            buf[--i] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        } while (rest != 0);
+        if (cents < 0) buf[--i] = '-';
+        size_t length = sizeof(buf) - i;
+        memcpy(out, buf + i, length);
+        return length;
+    }
+
+    Money operator+(const Money& other) const { return Money(cents + other.cents); }
+    Money operator-(const Money& other) const { return Money(cents - other.cents); }
+    Money& operator+=(const Money& other) { cents += other.cents; return *this; }
+    Money& operator-=(const Money& other) { cents -= other.cents; return *this; }
+    bool operator==(const Money& other) const { return cents == other.cents; }
+    bool operator!=(const Money& other) const { return cents != other.cents; }
+    bool operator<(const Money& other) const { return cents < other.cents; }
+    bool operator<=(const Money& other) const { return cents <= other.cents; }
+    bool operator>(const Money& other) const { return cents > other.cents; }
+    bool operator>=(const Money& other) const { return cents >= other.cents; }
+};
+
+// Snowflake-style 64-bit IDs for transactions and scheduled payments: 41
+// bits of milliseconds since EPOCH_MS, 10 bits of node (the process ID, so
+// two processes writing in the same millisecond still differ) and 12 bits
+// of sequence within the millisecond. IDs are stored as integers and only
+// turned into text for display and the journal. Each ID is strictly
+// greater than the last one this process issued: a clock that steps back
+// is ignored, and a sequence that runs out borrows the next millisecond.
+// Bit 63 is always clear.
+class IDGenerator {
+public:
+    static const long long EPOCH_MS = 1704067200000LL;   // 2024-01-01 UTC
+    static const int NODE_BITS = 10;
+    static const int SEQUENCE_BITS = 12;
+    std::atomic<unsigned long long> last;
+    unsigned long long node;
+
+    static IDGenerator& instance() {
+        static IDGenerator generator;
+        return generator;
+    }
+
+    IDGenerator() : last(0), node(static_cast<unsigned long long>(::getpid()) & ((1ULL << NODE_BITS) - 1)) {}
+
+    unsigned long long next() {
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - EPOCH_MS;
+        unsigned long long fromClock = (static_cast<unsigned long long>(ms < 0 ? 0 : ms) << (NODE_BITS + SEQUENCE_BITS)) |
+                                       (node << SEQUENCE_BITS);
+        unsigned long long previous = last.load();
+        while (true) {
+            unsigned long long following = previous + 1;
+            if ((previous & ((1ULL << SEQUENCE_BITS) - 1)) == (1ULL << SEQUENCE_BITS) - 1) {
+                following = (((previous >> (NODE_BITS + SEQUENCE_BITS)) + 1) << (NODE_BITS + SEQUENCE_BITS)) | (node << SEQUENCE_BITS);
+            }
+            unsigned long long id = fromClock > following ? fromClock : following;
+            if (last.compare_exchange_weak(previous, id)) return id;
+        }
+    }
+};
+
+// Operation metrics: a count and a latency histogram per instrumented
+// operation, exported in the Prometheus text format (see MetricsExporter).
+// Each thread records into its own shard, so recording never takes a lock
+// or bounces a cache line between cores; a dump adds the shards up. A
+// thread that exits hands its shard, counts included, to the next thread
+// that starts recording.
+//
+// Histogram buckets are HDR-style: exact below 8 ns, then 8 linear
+// sub-buckets per power of two, so every bucket is within 12.5% of the
+// values it holds, up to 2^40 ns (about 18 minutes); longer times land in
+// the last bucket.
+//
+// Building with -DSMART_WALLET_NO_METRICS compiles all of this out:
+// TIME_OPERATION expands to nothing and --metrics is refused.
+#ifndef SMART_WALLET_NO_METRICS
+enum MetricOperation {
+    METRIC_LOAD,
+    METRIC_SAVE,
+    METRIC_COMMIT,
+    METRIC_SCHEDULED_PAYMENTS,
+    METRIC_TRANSFER,
+    METRIC_PIN_CHECK,
+    METRIC_COUNT
+};
+
+struct MetricShard {
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_BITS = 40;
+    static const int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    // Written only by the owning thread; relaxed atomics let a dump read
+    // them while it runs.
+    std::atomic<unsigned long long> buckets[METRIC_COUNT][BUCKETS];
+    std::atomic<unsigned long long> totalNs[METRIC_COUNT];
+    MetricShard* next;
+    bool inUse;
+
+    MetricShard() : next(nullptr), inUse(true) {
+        for (int op = 0; op < METRIC_COUNT; op++) {
+            for (int b = 0; b < BUCKETS; b++) {
+                buckets[op][b].store(0, std::memory_order_relaxed);
+            }
+            totalNs[op].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static int bucketFor(unsigned long long ns) {
+        if (ns < static_cast<unsigned long long>(SUB_BUCKETS)) return static_cast<int>(ns);
+        int top = 63 - __builtin_clzll(ns);
+        int shift = top - SUB_BUCKET_BITS;
+        int bucket = (shift + 1) * SUB_BUCKETS + static_cast<int>((ns >> shift) & (SUB_BUCKETS - 1));
+        return bucket < BUCKETS ? bucket : BUCKETS - 1;
+    }
+
+    // Smallest value above everything the bucket holds.
+    static unsigned long long bucketLimit(int bucket) {
+        if (bucket < SUB_BUCKETS) return static_cast<unsigned long long>(bucket) + 1;
+        int shift = bucket / SUB_BUCKETS - 1;
+        return static_cast<unsigned long long>(SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << shift;
+    }
+
+    void add(int op, unsigned long long ns) {
+        std::atomic<unsigned long long>& slot = buckets[op][bucketFor(ns)];
+        slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totalNs[op].store(totalNs[op].load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    }
+};
+
+class Metrics {
+public:
+    std::mutex shardLock;
+    MetricShard* shards;
+
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    static const char* operationName(int op) {
+        static const char* names[METRIC_COUNT] = {"load", "save", "commit", "scheduled_payments", "transfer", "pin_check"};
+        return names[op];
+    }
+
+    Metrics() : shards(nullptr) {}
+
+    MetricShard* acquire() {
+        std::lock_guard<std::mutex> guard(shardLock);
+        for (MetricShard* shard = shards; shard != nullptr; shard = shard->next) {
+            if (!shard->inUse) {
+                shard->inUse = true;
+                return shard;
+            }
+        }
+        MetricShard* shard = new MetricShard();
+        shard->next = shards;
+        shards = shard;
+        return shard;
+    }
+
+    void release(MetricShard* shard) {
+        std::lock_guard<std::mutex> guard(shardLock);
+        shard->inUse = false;
+    }
+
+    // Gives each thread its shard on first use and returns it when the
+    // thread exits.
+    struct ShardHandle {
+        MetricShard* shard;
+        ShardHandle() : shard(nullptr) {}
+        ~ShardHandle() {
+            if (shard != nullptr) Metrics::instance().release(shard);
+        }
+    };
+
+    void record(int op, unsigned long long ns) {
+        static thread_local ShardHandle handle;
+        if (handle.shard == nullptr) handle.shard = acquire();
+        handle.shard->add(op, ns);
+    }
+
+    // Prometheus text exposition of every operation seen so far: a
+    // cumulative bucket line for each non-empty bucket, then +Inf, sum and
+    // count.
+    std::string dump() {
+        unsigned long long* merged = new unsigned long long[MetricShard::BUCKETS];
+        std::string out = "# HELP wallet_operation_seconds Time taken by BankingSystem operations.\n"
+                     "# TYPE wallet_operation_seconds histogram\n";
+        char line[160];
+        for (int op = 0; op < METRIC_COUNT; op++) {
+            unsigned long long totalNs = 0;
+            for (int b = 0; b < MetricShard::BUCKETS; b++) {
+                merged[b] = 0;
+            }
+            {
+                std::lock_guard<std::mutex> guard(shardLock);
+                for (MetricShard* shard = shards; shard != nullptr; shard = shard->next) {
+                    for (int b = 0; b < MetricShard::BUCKETS; b++) {
+                        merged[b] += shard->buckets[op][b].load(std::memory_order_relaxed);
+                    }
+                    totalNs += shard->totalNs[op].load(std::memory_order_relaxed);
+                }
+            }
+            unsigned long long cumulative = 0;
+            for (int b = 0; b < MetricShard::BUCKETS; b++) {
+                if (merged[b] == 0) continue;
+                cumulative += merged[b];
+                snprintf(line, sizeof(line), "wallet_operation_seconds_bucket{op=\"%s\",le=\"%.9g\"} %llu\n",
+                         operationName(op), MetricShard::bucketLimit(b) / 1e9, cumulative);
+                out += line;
+            }
+            snprintf(line, sizeof(line), "wallet_operation_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n", operationName(op), cumulative);
+            out += line;
+            snprintf(line, sizeof(line), "wallet_operation_seconds_sum{op=\"%s\"} %.9f\n", operationName(op), totalNs / 1e9);
+            out += line;
+            snprintf(line, sizeof(line), "wallet_operation_seconds_count{op=\"%s\"} %llu\n", operationName(op), cumulative);
+            out += line;
+        }
+        delete[] merged;
+        return out;
+    }
+};
+
+// Times the rest of the enclosing scope as one run of op.
+class MetricTimer {
+public:
+    int op;
+    std::chrono::steady_clock::time_point started;
+
+    explicit MetricTimer(int operation) : op(operation), started(std::chrono::steady_clock::now()) {}
+    ~MetricTimer() {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        Metrics::instance().record(op, ns < 0 ? 0 : static_cast<unsigned long long>(ns));
+    }
+};
+
+#define TIME_OPERATION(op) MetricTimer operationTimer(op)
+#else
+#define TIME_OPERATION(op)
+#endif
+
+// The operations a user can still take back, oldest first. Only the last
+// CAPACITY undoable records are kept and an entry older than UNDO_WINDOW
+// is dropped when next met, so the ring stays the same size however long
+// the account lives. Its slots are allocated on the first push.
+class UndoRing {
+public:
+    static const int CAPACITY = SecurityConfig::UNDO_DEPTH;
+    struct Entry {
+        unsigned long long id;
+        unsigned short type;
+        Money amount;
+        Money balanceBefore;
+        Money balanceAfter;
+        std::string otherAccount;
+        time_t timestamp;
+        // Shared by the two sides of a transfer, so each side can find the
+        // other; 0 for everything else.
+        unsigned long long transfer;
+    };
+    Entry* entries;
+    int first;
+    int count;
+
+    UndoRing() : entries(nullptr), first(0), count(0) {}
+    ~UndoRing() {
+        delete[] entries;
+    }
+
+    // Adds the newest entry, overwriting the oldest when the ring is full.
+    void push(unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter, const std::string& otherAccount,
+              long timestamp, unsigned long long transfer = 0);
+    // The k-th newest entry (0 = newest), or nullptr.
+    Entry* newest(int k = 0) const {
+        return k >= 0 && k < count ? &entries[(first + count - 1 - k) % CAPACITY] : nullptr;
+    }
+    Entry* at(int i) const {
+        return &entries[(first + i) % CAPACITY];
+    }
+    // Snapshots list the ring newest first; loaders add each entry as
+    // older than every one present, and the ones past CAPACITY are ignored.
+    void pushOldest(unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter, const std::string& otherAccount,
+                    long timestamp, unsigned long long transfer = 0);
+    // Index (0 = oldest) of the entry with the given record ID, or of the
+    // given transfer's entry, or -1.
+    int find(unsigned long long id) const;
+    int findTransfer(unsigned long long transfer) const;
+    // Drops entry i, closing the gap; at most CAPACITY entries move.
+    void remove(int i);
+    // Drops the n newest entries.
+    void dropNewest(int n = 1);
+    // Drops entries that fell out of the undo window; they are the oldest.
+    void expire(long now);
+    // How many of the newest entries are still inside the window; only
+    // these are saved.
+    int live(long now) const;
+    bool isEmpty() const {
+        return count == 0;
+    }
+    int getCount() const {
+        return count;
+    }
+    void clear() {
+        delete[] entries;
+        entries = nullptr;
+        first = 0;
+        count = 0;
+    }
+
+private:
+    static void set(Entry& entry, unsigned long long id, unsigned short type, Money amount, Money balanceBefore, Money balanceAfter,
+                    const std::string& otherAccount, long timestamp, unsigned long long transfer);
+    UndoRing(const UndoRing&);
+    UndoRing& operator=(const UndoRing&);
+};
+
+// Transaction types the bank itself records. TransactionTypeTable seeds
+// these codes in this order. The security entries written alongside money
+// movements are fixed too, so concurrent transfers never grow the table;
+// other security entries ("SECURITY: LOGIN_SUCCESS", ...) and names it does
+// not recognise from older files are interned after them as they appear.
+enum TransactionType {
+    TXN_ACCOUNT_CREATION,
+    TXN_DEPOSIT,
+    TXN_WITHDRAW,
+    TXN_TRANSFER_OUT,
+    TXN_TRANSFER_IN,
+    TXN_SCHEDULED_TRANSFER_OUT,
+    TXN_SCHEDULED_TRANSFER_IN,
+    TXN_UNDO_DEPOSIT,
+    TXN_UNDO_WITHDRAW,
+    TXN_UNDO_TRANSFER_OUT,
+    TXN_UNDO_TRANSFER_IN,
+    TXN_SECURITY_DEPOSIT,
+    TXN_SECURITY_WITHDRAWAL,
+    TXN_SECURITY_TRANSFER_OUT,
+    TXN_SECURITY_TRANSFER_IN,
+    TXN_FIXED_COUNT,
+    TXN_NONE = 0xffff
+};
+
+enum TransactionTypeFlag {
+    TXF_UNDOABLE = 1,    // undoLast can reverse it
+    TXF_SCHEDULED = 2,   // produced by the payment scheduler
+    TXF_CREDIT = 4,      // money into the account
+    TXF_DEBIT = 8,       // money out of the account
+    TXF_TRANSFER = 16,   // carries the counterparty account
+    TXF_UNDO = 32,       // a reversal; never goes on the undo ring
+    TXF_SECURITY = 64    // audit entry, no money moves
+};
+
+// Maps type codes to their display names, flags and the code of the entry
+// that reverses them. Records store only the two-byte code; names are
+// interned once so every history shares them. Interning is serialised;
+// lookups are not, so the table must not grow while other threads read it.
+class TransactionTypeTable {
+public:
+    std::mutex internLock;
+    std::string* names;
+    unsigned char* flagBits;
+    unsigned short* reversals;
+    int count;
+    int capacity;
+    int* slots;
+    int slotCapacity;
+
+    static TransactionTypeTable& instance() {
+        static TransactionTypeTable table;
+        return table;
+    }
+
+    TransactionTypeTable();
+    ~TransactionTypeTable();
+
+    int slotFor(const std::string& name) const;
+
+    unsigned short define(const std::string& name, unsigned flags, unsigned short reversal);
+
+    // Returns the code for name, adding it if unseen. Security entries and
+    // reversal names are recognised by their prefix.
+    unsigned short intern(const std::string& name);
+
+    const std::string& name(unsigned short code) const {
+        return names[code];
+    }
+    bool has(unsigned short code, unsigned flag) const {
+        return (flagBits[code] & flag) != 0;
+    }
+    unsigned short reversal(unsigned short code) const {
+        return reversals[code];
+    }
+    int size() const {
+        return count;
+    }
+
+private:
+    TransactionTypeTable(const TransactionTypeTable&);
+    TransactionTypeTable& operator=(const TransactionTypeTable&);
+};
+
+// A user's transaction history stored column by column: timestamps, amounts,
+// balances, type codes and IDs each sit in their own contiguous array, and
+// the other-account text of every record is packed into one character
+// buffer. Scans and aggregations touch only the columns they need.
+// Records are appended in time order, so the timestamp column doubles as a
+// sorted index for range queries; removal shifts the later rows down. If the
+// clock ever steps back, sorted is cleared and queries fall back to a scan.
+class TransactionHistory {
+public:
+    // Loaders pre-size from the stored count, capped so a damaged count
+    // cannot trigger a huge allocation.
+    static const int MAX_RESERVE = 1 << 20;
+    static const unsigned long long TEXT_ID = 1ULL << 63;
+    static const int ID_TEXT_SIZE = 32;
+
+    struct Record {
+        std::string id;
+        unsigned short type;
+        Money amount;
+        Money balanceAfter;
+        std::string otherAccount;
+        time_t timestamp;
+    };
+    int count;
+    int capacity;
+    long long* timestamps;
+    Money* amounts;
+    Money* balances;
+    unsigned short* types;
+    unsigned long long* ids;
+    unsigned int* otherOffsets;
+    unsigned int* otherLengths;
+    char* text;
+    size_t textSize;
+    size_t textCapacity;
+    bool sorted;
+
+    TransactionHistory() : count(0), capacity(0), timestamps(nullptr), amounts(nullptr), balances(nullptr), types(nullptr),
+                           ids(nullptr), otherOffsets(nullptr), otherLengths(nullptr),
+                           text(nullptr), textSize(0), textCapacity(0), sorted(true) {}
+    ~TransactionHistory() {
+        release();
+    }
+
+    template <typename T>
+    static void resizeColumn(T*& column, int used, int newCapacity) {
+        T* grown = new T[newCapacity];
+        for (int i = 0; i < used; i++) {
+            grown[i] = column[i];
+        }
+        delete[] column;
+        column = grown;
+    }
+
+    // Sizes the columns for n records up front; loaders know the count.
+    void reserve(int n);
+
+    unsigned int appendText(const std::string& value);
+
+    // IDs read back from files: one that is not the prefix for its type
+    // followed by a number (hand-edited or foreign data) is kept verbatim
+    // in the text buffer, with TEXT_ID set and its offset and length in the
+    // low bits.
+    void addTransaction(const std::string& id, unsigned short type, Money amount, Money balanceAfter, const std::string& otherAccount, long timestamp);
+
+    void addTransaction(unsigned long long id, unsigned short type, Money amount, Money balanceAfter, const std::string& otherAccount, long timestamp);
+
+    // Display prefix of the IDs of a type: "SEC" for audit entries, "UNDO"
+    // for reversals and "T" for the rest, as the older text IDs had.
+    static const char* idPrefix(unsigned short type);
+
+    static std::string formatID(unsigned long long id, unsigned short type) {
+        return idPrefix(type) + std::to_string(id);
+    }
+
+    // Accepts exactly what formatID produces for type.
+    static bool parseID(const std::string& text, unsigned short type, unsigned long long& id);
+
+    // Numeric ID for text, or 0 when it is not in the form formatID writes.
+    static unsigned long long idValue(const std::string& text, unsigned short type) {
+        unsigned long long id = 0;
+        return parseID(text, type, id) ? id : 0;
+    }
+
+    bool isTextID(int i) const {
+        return (ids[i] & TEXT_ID) != 0;
+    }
+    std::string idAt(int i) const;
+    // idAt without the string: data points at the ID's characters, numeric
+    // IDs being formatted into buf (ID_TEXT_SIZE characters); returns the
+    // length.
+    size_t idChars(int i, char* buf, const char*& data) const;
+    const std::string& typeAt(int i) const {
+        return TransactionTypeTable::instance().name(types[i]);
+    }
+    std::string otherAccountAt(int i) const {
+        return std::string(text + otherOffsets[i], otherLengths[i]);
+    }
+    // The characters of otherAccountAt(i), left in the text buffer.
+    const char* otherAccountData(int i) const {
+        return text + otherOffsets[i];
+    }
+    size_t otherAccountLength(int i) const {
+        return otherLengths[i];
+    }
+    bool hasOtherAccount(int i) const {
+        return otherLengths[i] > 0;
+    }
+
+    Record get(int i) const;
+
+    bool getLastTransaction(Record& out) const {
+        if (count == 0) return false;
+        out = get(count - 1);
+        return true;
+    }
+
+    void removeLastTransaction() {
+        if (count == 0) return;
+        count--;
+    }
+
+    // Removes the row and closes the gap; its text stays in the buffer
+    // until the history is cleared.
+    void removeAt(int i);
+
+    // Removes the most recent record of the given type whose amount and
+    // other account match.
+    bool removeMatchingFromBack(unsigned short type, Money amount, const std::string& other);
+
+    int getCount() const { return count; }
+
+    // First row whose timestamp is at or after t; needs sorted.
+    int lowerBound(long long t) const;
+
+    // First row whose timestamp is after t; needs sorted.
+    int upperBound(long long t) const;
+
+    // Number of rows with from <= timestamp <= to.
+    int countRange(long long from, long long to) const;
+
+    // Writes the row numbers of up to limit records with from <= timestamp
+    // <= to, oldest first, skipping the first offset matches. Returns how
+    // many were written, 0 when offset is past the last match. With a
+    // sorted history this is O(log n + limit).
+    int queryRange(long long from, long long to, int offset, int limit, int* rows) const;
+
+    // Row numbers of the newest n records, oldest first.
+    int queryLast(int n, int* rows) const;
+
+    void clear() {
+        count = 0;
+        textSize = 0;
+        sorted = true;
+    }
+
+    void release();
+
+private:
+    TransactionHistory(const TransactionHistory&);
+    TransactionHistory& operator=(const TransactionHistory&);
+};
+
+// Binary min-heap of scheduled payments ordered by executeAt (ties keep
+// scheduling order). Each node remembers its heap slot and an open-addressing
+// table maps payment IDs to nodes, so enqueue, dequeue and remove-by-ID are
+// all O(log n).
+// A recurring payment is one node holding its rule; when an occurrence runs
+// the node is moved to the next occurrence instead of every future
+// occurrence being queued up front.
+class PaymentPriorityQueue {
+public:
+    enum RecurUnit { RECUR_NONE = 0, RECUR_SECONDS = 's', RECUR_DAYS = 'd', RECUR_MONTHS = 'm' };
+
+    struct PQNode {
+        std::string id;
+        time_t executeAt;
+        std::string fromAccount;
+        std::string toAccount;
+        Money amount;
+        long long sequence;
+        int slot;
+        // Repeat rule: every `every` units counted from anchor, the first
+        // occurrence. maxRuns (0 = no limit) and endAt (0 = none) bound it;
+        // fired counts the occurrences already made.
+        char unit;
+        int every;
+        int maxRuns;
+        long long endAt;
+        long long anchor;
+        int fired;
+        PQNode(std::string i, long e, std::string f, std::string t, Money a): id(i), executeAt(e), fromAccount(f), toAccount(t), amount(a), sequence(0), slot(-1),
+                                                             unit(RECUR_NONE), every(0), maxRuns(0), endAt(0), anchor(e), fired(0) {}
+        bool recurring() const {
+            return unit != RECUR_NONE;
+        }
+    };
+
+    static bool isValidRecurUnit(int unit) {
+        return unit == RECUR_NONE || unit == RECUR_SECONDS || unit == RECUR_DAYS || unit == RECUR_MONTHS;
+    }
+
+    // Time of occurrence k (0 = the anchor). Days and months step the local
+    // calendar, so a monthly payment keeps its day of the month, falling
+    // back to the month's last day when the month is shorter.
+    static time_t occurrence(const PQNode* node, int k);
+
+    // Moves a dequeued recurring node to its next occurrence and queues it
+    // again. Returns false, leaving the node with the caller, when it is a
+    // one-off or its rule is exhausted.
+    bool reschedule(PQNode* node);
+    PQNode** heap;
+    int capacity;
+    int count;
+    long long nextSequence;
+    PQNode** idTable;
+    int idCapacity;
+
+    PaymentPriorityQueue();
+    ~PaymentPriorityQueue() {
+        clear();
+        delete[] heap;
+        delete[] idTable;
+    }
+
+    static bool before(const PQNode* a, const PQNode* b) {
+        if (a->executeAt != b->executeAt) return a->executeAt < b->executeAt;
+        return a->sequence < b->sequence;
+    }
+
+    void place(PQNode* node, int slot) {
+        heap[slot] = node;
+        node->slot = slot;
+    }
+
+    void siftUp(int slot);
+
+    void siftDown(int slot);
+
+    int idSlot(const std::string& id) const;
+
+    void indexId(PQNode* node);
+
+    void unindexId(PQNode* node);
+
+    PQNode* enqueue(std::string id, long executeAt, std::string fromAccount, std::string toAccount, Money amount) {
+        PQNode* newNode = new PQNode(id, executeAt, fromAccount, toAccount, amount);
+        insert(newNode);
+        return newNode;
+    }
+
+    void insert(PQNode* newNode);
+
+    // Detaches the node in the given heap slot; the caller owns it.
+    PQNode* removeAt(int slot);
+
+    PQNode* dequeue() {
+        if (count == 0) return nullptr;
+        return removeAt(0);
+    }
+
+    // Removes the earliest payments due at or before now, up to limit, and
+    // returns them in execution order (the caller owns the nodes and
+    // delete[]s the array). Due nodes are found by walking the heap from
+    // the root, which never descends below a payment that is not due. A
+    // large batch is cut out of the array in one pass and the rest
+    // re-heapified instead of popping nodes one at a time; a limit that is
+    // small next to the queue just pops.
+    PQNode** takeDue(time_t now, int limit, int& taken);
+
+    PQNode* find(const std::string& id) const {
+        return idTable[idSlot(id)];
+    }
+
+    PQNode* remove(const std::string& id) {
+        PQNode* node = find(id);
+        if (node == nullptr) return nullptr;
+        return removeAt(node->slot);
+    }
+
+    PQNode* peek() {
+        return count == 0 ? nullptr : heap[0];
+    }
+    bool isEmpty() const {
+        return count == 0;
+    }
+    int size() const {
+        return count;
+    }
+    // Heap order, not execution order; see sortByExecution.
+    PQNode* at(int i) const {
+        return heap[i];
+    }
+    void clear();
+
+    // In-place heapsort of a node array into execution order, used when
+    // payments have to be listed or written out in the order they will run.
+    static void sortByExecution(PQNode** nodes, int n);
+
+    static void siftLatest(PQNode** nodes, int slot, int n);
+};
+
+// How commit() makes journal records durable:
+//   sync   - the caller writes and fsyncs them itself before returning.
+//   group  - the writer thread gathers the records of every commit made
+//            within the window and makes them durable with one write and
+//            fsync; each caller waits for the fsync that covers it.
+//   async  - the caller returns at once and the writer thread makes the
+//            records durable within the window; a crash can lose them.
+enum DurabilityMode {
+    DURABILITY_SYNC,
+    DURABILITY_GROUP,
+    DURABILITY_ASYNC
+};
+
+// Process-wide durability setting, taken from the command line before any
+// BankingSystem is created.
+struct DurabilityConfig {
+    DurabilityMode mode;
+    int windowMicros;
+
+    static DurabilityConfig& current() {
+        static DurabilityConfig config = {DURABILITY_SYNC, 0};
+        return config;
+    }
+
+    // Parses "sync", "group", "async", optionally followed by ":<window ms>".
+    // Group commit defaults to no window: the records queued while one
+    // fsync runs already share the next. Async defaults to 2 ms.
+    bool parse(const std::string& text) {
+        size_t colon = text.find(':');
+        std::string name = text.substr(0, colon);
+        if (name == "sync") mode = DURABILITY_SYNC;
+        else if (name == "group") mode = DURABILITY_GROUP;
+        else if (name == "async") mode = DURABILITY_ASYNC;
+        else return false;
+        windowMicros = mode == DURABILITY_ASYNC ? 2000 : 0;
+        if (colon == std::string::npos) return true;
+        char* end = nullptr;
+        double ms = strtod(text.c_str() + colon + 1, &end);
+        if (end == text.c_str() + colon + 1 || *end != '\0' || ms < 0 || ms > 1000) return false;
+        windowMicros = static_cast<int>(ms * 1000);
+        return true;
+    }
+};
+
+// Append-only journal of state changes made since the last snapshot of
+// bank_data.txt. Records are queued as they happen and written in batches
+// of one write()+fsync(); BankingSystem folds the journal back into the
+// snapshot (checkpoint) once it grows past JOURNAL_CHECKPOINT_BYTES.
+//
+// Each record is one line: a 16-digit hex checksum, then tab-separated
+// fields with tabs, newlines and backslashes escaped. The first line holds
+// the snapshot generation the journal applies to, so a journal left over
+// from before a completed checkpoint is never replayed twice.
+//
+// A batch run suspends the journal and checkpoints once at the end instead
+// of logging each of its operations. Concurrent transfers append from
+// several threads, so records go onto a lock-free stack that whoever
+// writes next (a committing thread, or the writer thread outside sync
+// mode) takes whole; writes and syncs are serialised on writeLock.
+class Journal {
+public:
+    struct Record {
+        Record* next;
+        std::string line;
+    };
+
+    std::string fileName;
+    int fd;
+    long long generation;
+    std::atomic<long long> bytes;
+    long long cleanBytes;
+    bool suspended;
+    std::atomic<Record*> queued;
+    // Records ever queued, and how many of those are durable (or were
+    // dropped by a reset, the snapshot covering them); a commit waits for
+    // durableCount to reach the queuedCount it saw.
+    std::atomic<long long> queuedCount;
+    long long durableCount;
+    std::mutex writeLock;
+    std::condition_variable durableChanged;
+    std::atomic<bool> failed;
+    DurabilityMode mode;
+    int windowMicros;
+    std::thread writer;
+    std::mutex writerLock;
+    std::condition_variable writerWake;
+    bool writeRequested;
+    bool writerStopping;
+
+    Journal() : fileName(""), fd(-1), generation(0), bytes(0), cleanBytes(-1), suspended(false), queued(nullptr), queuedCount(0),
+                durableCount(0), failed(false), mode(DURABILITY_SYNC), windowMicros(0), writeRequested(false), writerStopping(false) {}
+    ~Journal() {
+        stopWriter();
+        close();
+    }
+
+    static std::string escape(const std::string& field) {
+        std::string out;
+        appendEscaped(out, field);
+        return out;
+    }
+
+    static void appendEscaped(std::string& out, const std::string& field);
+
+    static std::string checksum(const std::string& body) {
+        char buf[17];
+        snprintf(buf, sizeof(buf), "%016llx", hashString(body));
+        return std::string(buf);
+    }
+
+    // Splits a checked line back into unescaped fields. Returns the number
+    // of fields, or -1 if the checksum does not match.
+    static int parse(const std::string& line, std::string* fields, int maxFields);
+
+    bool isOpen() const {
+        return fd != -1;
+    }
+
+    // True while nothing has happened since the journal was last reset,
+    // i.e. the snapshot on disk is current.
+    bool isClean() const {
+        return fd != -1 && !suspended && queued.load() == nullptr && bytes.load() == cleanBytes;
+    }
+
+    // Keeps isClean() false until the next reset: for changes that went
+    // past the journal and could not be checkpointed either.
+    void markUnsaved() {
+        cleanBytes = -1;
+    }
+
+    void append(const std::string* fields, int count);
+
+    // Writes data at the end of the journal, retrying short writes; written
+    // is how much of it reached the file, all of it when this returns true.
+    bool writeAll(const std::string& data, size_t& written);
+
+    // Takes every queued record, oldest first, into data; returns how many.
+    int takeQueued(std::string& data);
+
+    // Writes and syncs everything queued; writeLock must be held. bytes
+    // grows only by what reached the file. The first failure is reported
+    // through walletNotice and sets failed, which commit() then returns.
+    bool flushLocked();
+
+    // Makes every queued record durable in the calling thread.
+    bool sync() {
+        std::lock_guard<std::mutex> guard(writeLock);
+        return flushLocked();
+    }
+
+    // Makes the records queued so far durable as the durability mode asks.
+    // Returns false once a write has failed, in any mode.
+    bool commit();
+
+    // Starts the writer thread for group and async modes; sync mode needs none.
+    void startWriter(const DurabilityConfig& config);
+
+    // Stops the writer thread after a last write of anything still queued.
+    void stopWriter();
+
+    // Writer thread: once woken by a commit it waits out the window so
+    // that later commits share the write, then writes everything queued.
+    void runWriter();
+
+    // Opens the journal for appending after replay; validBytes is the end
+    // of the last intact record, anything after it is a torn write. With no
+    // usable journal for this generation a fresh one is started.
+    bool open(const std::string& name, long long gen, long long validBytes);
+
+    // Starts an empty journal for a new snapshot generation. Records still
+    // queued are dropped: the snapshot just written covers them.
+    bool reset(long long gen);
+
+    void close() {
+        std::lock_guard<std::mutex> guard(writeLock);
+        closeFile();
+    }
+
+    void closeFile();
+};
+
+// Checksum for snapshot payloads: FNV-1a folded over 8-byte words so that
+// verifying a large snapshot costs far less than parsing it.
+inline unsigned long long checksumBytes(const char* data, size_t size) {
+    unsigned long long h = 1469598103934665603ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        unsigned long long word = 0;
+        for (int b = 7; b >= 0; b--) {
+            word = (word << 8) | static_cast<unsigned char>(data[i + b]);
+        }
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// Binary snapshot layout (all integers little-endian):
+//   header  magic "SWSNAPSH", u32 version, u32 header size, i64 user count,
+//           i64 payment count, i64 nextUserID, i64 invalidIDAttempts,
+//           i64 journal generation, i64 payload size, u64 payload checksum,
+//           u64 header checksum
+//   payload transaction type names (u32 count, then strings), u32 segment
+//           count and per segment a file name and i64 user count, users
+//           stored inline (see User::saveBinary), then scheduled
+//           payments: id, i64 executeAt,
+//           from, to, amount, u8 repeat unit and, for a recurring payment,
+//           u32 every, u32 maxRuns, i64 endAt, i64 anchor, u32 fired
+// Strings are a u32 length followed by the bytes, money is i64 cents, and
+// transaction types are u16 indexes into the payload's name table.
+// Version 1 snapshots stored money as raw IEEE-754 doubles; versions 1 and 2
+// have no name table and store each type as a string; versions before 4
+// have no repeat rules and before 5 no segment list. Before 6 transaction
+// and undo IDs were strings; now they are i64 numbers (see IDGenerator),
+// and a transaction ID kept as text is stored as -1 followed by the string.
+// Version 7 adds an i64 transfer ID to each undo entry and holds only the
+// entries still inside the undo window. All still load.
+//
+// A checkpoint writes a manifest: the header and payments, with every user
+// in a segment file of up to SEGMENT_USERS accounts named in the segment
+// list. Each segment file is itself a snapshot with no segments and no
+// payments, so it carries its own type table. The converter writes a
+// single file with all users inline.
+class SnapshotWriter {
+public:
+    static const int VERSION = 7;
+    static const int HEADER_SIZE = 80;
+    std::string buffer;
+
+    void putU8(unsigned value) {
+        buffer += static_cast<char>(value & 0xff);
+    }
+    void putU16(unsigned value) {
+        buffer += static_cast<char>(value & 0xff);
+        buffer += static_cast<char>((value >> 8) & 0xff);
+    }
+    void putU32(unsigned long value) {
+        for (int i = 0; i < 4; i++) {
+            buffer += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+    void putI64(long long value) {
+        unsigned long long bits = static_cast<unsigned long long>(value);
+        for (int i = 0; i < 8; i++) {
+            buffer += static_cast<char>((bits >> (8 * i)) & 0xff);
+        }
+    }
+    void putMoney(const Money& value) {
+        putI64(value.cents);
+    }
+    void putString(const std::string& value) {
+        putU32(static_cast<unsigned long>(value.length()));
+        buffer += value;
+    }
+    void putType(unsigned short code) {
+        putU16(code);
+    }
+    // Writes every interned type name so the codes that follow can be
+    // mapped back on load, whatever order that process interns them in.
+    void putTypeTable() {
+        const TransactionTypeTable& table = TransactionTypeTable::instance();
+        putU32(static_cast<unsigned long>(table.size()));
+        for (int i = 0; i < table.size(); i++) {
+            putString(table.name(static_cast<unsigned short>(i)));
+        }
+    }
+
+    // Reserves room for the header; finish() fills it in once the payload
+    // is complete.
+    void begin() {
+        buffer.assign(HEADER_SIZE, '\0');
+    }
+    void finish(long long userCount, long long paymentCount, long long nextUserID, long long invalidIDAttempts, long long generation) {
+        std::string payload = buffer.substr(HEADER_SIZE);
+        unsigned long long payloadChecksum = checksumBytes(buffer.data() + HEADER_SIZE, buffer.length() - HEADER_SIZE);
+        buffer.clear();
+        buffer += "SWSNAPSH";
+        putU32(VERSION);
+        putU32(HEADER_SIZE);
+        putI64(userCount);
+        putI64(paymentCount);
+        putI64(nextUserID);
+        putI64(invalidIDAttempts);
+        putI64(generation);
+        putI64(static_cast<long long>(payload.length()));
+        putI64(static_cast<long long>(payloadChecksum));
+        putI64(static_cast<long long>(checksumBytes(buffer.data(), buffer.length())));
+        buffer += payload;
+    }
+};
+
+// Bounds-checked cursor over a snapshot image; any overrun clears ok and
+// yields zero values so callers can check once at the end.
+class SnapshotReader {
+public:
+    const char* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+    int version;
+    unsigned short* typeMap;
+    unsigned long typeCount;
+
+    SnapshotReader(const char* d, size_t n) : data(d), size(n), pos(0), ok(true), version(SnapshotWriter::VERSION), typeMap(nullptr), typeCount(0) {}
+    ~SnapshotReader() {
+        delete[] typeMap;
+    }
+
+    bool has(size_t n) {
+        if (!ok || size - pos < n) {
+            ok = false;
+            return false;
+        }
+        return true;
+    }
+    unsigned getU8() {
+        if (!has(1)) return 0;
+        return static_cast<unsigned char>(data[pos++]);
+    }
+    unsigned long getU32() {
+        if (!has(4)) return 0;
+        unsigned long value = 0;
+        for (int i = 3; i >= 0; i--) {
+            value = (value << 8) | static_cast<unsigned char>(data[pos + i]);
+        }
+        pos += 4;
+        return value;
+    }
+    long long getI64() {
+        if (!has(8)) return 0;
+        unsigned long long bits = 0;
+        for (int i = 7; i >= 0; i--) {
+            bits = (bits << 8) | static_cast<unsigned char>(data[pos + i]);
+        }
+        pos += 8;
+        return static_cast<long long>(bits);
+    }
+    Money getMoney() {
+        long long bits = getI64();
+        if (version >= 2) return Money(bits);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return Money::fromDouble(value);
+    }
+    std::string getString() {
+        unsigned long length = getU32();
+        if (!has(length)) return std::string();
+        std::string value(data + pos, length);
+        pos += length;
+        return value;
+    }
+    unsigned getU16() {
+        if (!has(2)) return 0;
+        unsigned value = static_cast<unsigned char>(data[pos]) | (static_cast<unsigned char>(data[pos + 1]) << 8);
+        pos += 2;
+        return value;
+    }
+    // Reads the payload's name table and maps each stored code onto this
+    // process's code for the same name.
+    void getTypeTable() {
+        if (version < 3) return;
+        unsigned long n = getU32();
+        if (n > 0xffff || !has(n * 4)) {
+            ok = false;
+            return;
+        }
+        delete[] typeMap;
+        typeMap = new unsigned short[n];
+        typeCount = n;
+        for (unsigned long i = 0; i < n; i++) {
+            typeMap[i] = TransactionTypeTable::instance().intern(getString());
+        }
+    }
+    unsigned short getType() {
+        if (version < 3) return TransactionTypeTable::instance().intern(getString());
+        unsigned code = getU16();
+        if (code >= typeCount) {
+            ok = false;
+            return TXN_NONE;
+        }
+        return typeMap[code];
+    }
+
+private:
+    SnapshotReader(const SnapshotReader&);
+    SnapshotReader& operator=(const SnapshotReader&);
+};
+
+// The fixed-size header at the start of every snapshot image. parse()
+// checks the magic, version, sizes and both checksums.
+struct SnapshotHeader {
+    int version;
+    long long userCount;
+    long long paymentCount;
+    long long nextUserID;
+    long long invalidIDAttempts;
+    long long generation;
+
+    bool parse(const char* image, size_t size) {
+        if (size < static_cast<size_t>(SnapshotWriter::HEADER_SIZE) || memcmp(image, "SWSNAPSH", 8) != 0) return false;
+        SnapshotReader header(image, SnapshotWriter::HEADER_SIZE);
+        header.pos = 8;
+        unsigned long loadedVersion = header.getU32();
+        unsigned long headerSize = header.getU32();
+        userCount = header.getI64();
+        paymentCount = header.getI64();
+        nextUserID = header.getI64();
+        invalidIDAttempts = header.getI64();
+        generation = header.getI64();
+        long long payloadBytes = header.getI64();
+        unsigned long long payloadChecksum = static_cast<unsigned long long>(header.getI64());
+        unsigned long long headerChecksum = static_cast<unsigned long long>(header.getI64());
+        if (loadedVersion < 1 || loadedVersion > static_cast<unsigned long>(SnapshotWriter::VERSION) || headerSize != SnapshotWriter::HEADER_SIZE) return false;
+        if (checksumBytes(image, SnapshotWriter::HEADER_SIZE - 8) != headerChecksum) return false;
+        if (payloadBytes != static_cast<long long>(size - headerSize)) return false;
+        if (checksumBytes(image + headerSize, size - headerSize) != payloadChecksum) return false;
+        version = static_cast<int>(loadedVersion);
+        return userCount >= 0 && paymentCount >= 0;
+    }
+};
+
+// Read-only memory mapping of a whole data file.
+class MappedFile {
+public:
+    const char* data;
+    size_t size;
+    int fd;
+
+    MappedFile() : data(nullptr), size(0), fd(-1) {}
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& fileName);
+
+    void close();
+};
+
+// Parses the line-per-field text format in place over a mapped file,
+// following the getline / >> / ignore() sequence of the stream loader it
+// replaced. A "\r\n" line ending is treated like "\n". Reading past the end
+// sets failed; a number that does not parse just returns false, as a
+// failed >> did.
+class TextCursor {
+public:
+    const char* pos;
+    const char* end;
+    bool failed;
+
+    TextCursor(const char* data, size_t size) : pos(data), end(data + size), failed(false) {}
+
+    bool atEnd() const {
+        return failed || pos >= end;
+    }
+
+    bool readLine(std::string& out) {
+        if (pos >= end) {
+            failed = true;
+            out.clear();
+            return false;
+        }
+        const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        const char* lineEnd = newline != nullptr ? newline : end;
+        const char* textEnd = lineEnd;
+        if (textEnd > pos && textEnd[-1] == '\r') textEnd--;
+        out.assign(pos, textEnd - pos);
+        pos = newline != nullptr ? newline + 1 : end;
+        return true;
+    }
+
+    // Copies the next whitespace-delimited token into buf (bounded, so the
+    // number parsers never read beyond the mapping).
+    bool readToken(char* buf, size_t bufSize) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) pos++;
+        if (pos >= end) {
+            failed = true;
+            return false;
+        }
+        size_t n = 0;
+        const char* p = pos;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+            if (n + 1 >= bufSize) return false;
+            buf[n++] = *p++;
+        }
+        buf[n] = '\0';
+        return true;
+    }
+
+    bool readLong(long long& value) {
+        char buf[32];
+        if (!readToken(buf, sizeof(buf))) return false;
+        char* parsedEnd;
+        long long parsed = strtoll(buf, &parsedEnd, 10);
+        if (parsedEnd == buf || *parsedEnd != '\0') return false;
+        pos += parsedEnd - buf;
+        value = parsed;
+        return true;
+    }
+
+    bool readInt(int& value) {
+        long long parsed;
+        if (!readLong(parsed)) return false;
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    bool readMoney(Money& value) {
+        char buf[64];
+        if (!readToken(buf, sizeof(buf))) return false;
+        if (!Money::parse(buf, value)) return false;
+        pos += strlen(buf);
+        return true;
+    }
+
+    bool readWord(std::string& out) {
+        char buf[64];
+        if (!readToken(buf, sizeof(buf))) return false;
+        out = buf;
+        pos += out.length();
+        return true;
+    }
+
+    // The ignore() after a number: drops the rest of the line ending.
+    void skipLineEnd() {
+        if (pos < end && *pos == '\r') pos++;
+        if (pos < end && *pos == '\n') pos++;
+    }
+};
+
+// Result of an operation on the wallet. The core never prints; front ends
+// turn these into messages (see operationStatusText).
+enum OperationStatus {
+    OP_OK,
+    OP_INVALID_AMOUNT,
+    OP_INSUFFICIENT_FUNDS,
+    OP_UNKNOWN_ACCOUNT,
+    OP_SAME_ACCOUNT,
+    OP_UNKNOWN_PAYMENT,
+    OP_BAD_CREDENTIALS,
+    OP_BAD_PIN,
+    OP_ACCOUNT_LOCKED,
+    OP_INVALID_SCHEDULE,
+    OP_INVALID_DETAILS,
+    OP_EMAIL_TAKEN,
+    OP_NOTHING_TO_UNDO,
+    OP_UNDO_EXPIRED,
+    OP_NOT_UNDOABLE,
+    OP_STATUS_COUNT
+};
+
+inline const char* operationStatusText(OperationStatus status) {
+    switch (status) {
+        case OP_OK: return "ok";
+        case OP_INVALID_AMOUNT: return "invalid amount";
+        case OP_INSUFFICIENT_FUNDS: return "insufficient funds";
+        case OP_UNKNOWN_ACCOUNT: return "unknown account";
+        case OP_SAME_ACCOUNT: return "transfer to same account";
+        case OP_UNKNOWN_PAYMENT: return "unknown payment";
+        case OP_BAD_CREDENTIALS: return "wrong user ID or password";
+        case OP_BAD_PIN: return "wrong PIN";
+        case OP_ACCOUNT_LOCKED: return "account locked";
+        case OP_INVALID_SCHEDULE: return "invalid schedule";
+        case OP_INVALID_DETAILS: return "invalid account details";
+        case OP_EMAIL_TAKEN: return "email already in use";
+        case OP_NOTHING_TO_UNDO: return "nothing to undo";
+        case OP_UNDO_EXPIRED: return "undo window has passed";
+        case OP_NOT_UNDOABLE: return "transaction cannot be undone";
+        default: return "unknown";
+    }
+}
+
+// Messages the wallet produces on its own: scheduled payments run, a save
+// that failed, a damaged snapshot. A front end installs a handler to show
+// them; without one they are dropped.
+typedef void (*NoticeHandler)(const std::string& message);
+
+inline NoticeHandler& noticeHandler() {
+    static NoticeHandler handler = nullptr;
+    return handler;
+}
+
+inline void walletNotice(const std::string& message) {
+    if (noticeHandler() != nullptr) noticeHandler()(message);
+}
+
+class User {
+public:
+    std::string name;
+    std::string userID;
+    std::string password;
+    std::string pin;
+    std::string accountNumber;
+    std::string email;
+    std::string phone;
+    std::string address;
+    Money balance;
+    std::string accountType;
+    std::string dateCreated;
+    int loginAttempts;
+    long lastLoginAttempt;
+    bool isLocked;
+    TransactionHistory transactions;
+    UndoRing undoRing;
+    Journal* journal;
+    // Set by every change that is journalled, cleared once a checkpoint has
+    // written the account's segment.
+    bool dirty;
+
+    User() : name(""), userID(""), password(""), pin(""), accountNumber(""), email(""), phone(""), address(""), balance(), accountType(""), dateCreated(""), loginAttempts(0), lastLoginAttempt(0), isLocked(false), journal(nullptr), dirty(true) {}
+
+    User(std::string n, std::string id, std::string pwd, std::string userPin, std::string email_, std::string phone_, std::string addr, std::string accType, Money initialBalance): name(n), userID(id), password(pwd), pin(userPin), accountNumber(""), email(email_), phone(phone_), address(addr), balance(initialBalance), accountType(accType), dateCreated(""), loginAttempts(0), lastLoginAttempt(0), isLocked(false), journal(nullptr), dirty(true) {
+        accountNumber = generateAccountNumber();
+        dateCreated = getCurrentDate();
+    }
+
+    std::string generateAccountNumber();
+
+    std::string getCurrentDate();
+
+    bool isWeakPassword(const std::string& pwd);
+   
+    bool isWeakPIN(const std::string& pin);
+
+    bool setEmail(const std::string &e);
+   
+    bool setPhone(const std::string &p);
+   
+    bool setAddress(const std::string &a);
+   
+    bool setPassword(const std::string &pwd);
+   
+    bool setPIN(const std::string &p);
+
+    void logField(const std::string& field, const std::string& value);
+
+    void logAuthState();
+
+    // Journals a record; transfer is the undo ring's transfer ID, written
+    // only for the two sides of a transfer.
+    void logTransaction(unsigned long long id, unsigned short type, Money amount, Money balanceAfter, const std::string& otherAccount, long timestamp, bool undoable, Money balanceBefore,
+                        unsigned long long transfer = 0);
+
+    // Journals that these undo ring entries are gone.
+    void logUndoRemoved(const unsigned long long* ids, int n);
+
+    bool verifyPIN(std::string inputPIN);
+
+    bool verifyPassword(std::string inputPassword);
+
+    bool checkPIN(const std::string& inputPIN);
+   
+    bool checkPassword(const std::string& inputPassword);
+
+    bool canUndo() const {
+        return !undoRing.isEmpty();
+    }
+   
+    // Records a transaction and returns its ID. Undoable types also go on
+    // the undo ring, tagged with transfer when they are one side of it.
+    unsigned long long addTransactionRecord(unsigned short type, Money amount, Money balanceAfter, const std::string &otherAccount = "",
+                                            unsigned long long transfer = 0);
+   
+    // Records n transactions at once, in order: the history grows once for
+    // all of them and the balance is set once, to the last balancesAfter.
+    // Undoable types go on the undo ring as with addTransactionRecord.
+    void addTransactionRecords(const unsigned short* types, const Money* amounts, const Money* balancesAfter,
+                               const std::string* const* otherAccounts, int n);
+
+    // Records the opposite of an undo ring entry, moving the balance back
+    // by its amount. The caller removes the entry.
+    void addReversal(const UndoRing::Entry& entry, long now);
+
+    void addSecurityLog(const std::string &action, const std::string &details = "") {
+        addSecurityLog(TransactionTypeTable::instance().intern("SECURITY: " + action), details);
+    }
+
+    void addSecurityLog(unsigned short type, const std::string &details);
+
+    int getTransactionCount() const { return transactions.getCount(); }
+    bool hasTransactions() const { return transactions.getCount() > 0; }
+   
+    void saveToFile(std::ofstream& file);
+
+    // Returns false when the text ran out before the user was complete.
+    bool loadFromText(TextCursor& in);
+
+    void saveBinary(SnapshotWriter& out);
+
+    bool loadBinary(SnapshotReader& in);
+};
+
+// Open-addressing (linear probing) index from one string field of User to
+// the user's slot in BankingSystem::users. Keys are not copied: each entry
+// keeps the key hash and the user slot, and the key is compared through the
+// indexed field, so the table stays small even with millions of accounts.
+class UserIndex {
+public:
+    struct Entry {
+        unsigned long long hash;
+        int userIndex;
+    };
+    Entry* entries;
+    int capacity;
+    int count;
+    std::string User::* field;
+
+    UserIndex(std::string User::* f) : entries(nullptr), capacity(0), count(0), field(f) {
+        allocate(16);
+    }
+    ~UserIndex() {
+        delete[] entries;
+    }
+
+    void allocate(int newCapacity);
+
+    void grow();
+
+    int findSlot(const std::string& key, unsigned long long h, User** users) const;
+
+    int find(const std::string& key, User** users) const {
+        int pos = findSlot(key, hashString(key), users);
+        return pos == -1 ? -1 : entries[pos].userIndex;
+    }
+
+    // Keeps the first user seen for a key, matching what a front-to-back
+    // scan of the users array would return.
+    bool insert(int userIndex, User** users);
+
+    // Backward-shift deletion, so lookups never have to skip tombstones.
+    bool remove(const std::string& key, int userIndex, User** users);
+
+    void clear();
+};
+
+// Striped locks over accounts: the user at index i is guarded by stripe
+// i % STRIPES. An operation on two accounts takes both stripes in ascending
+// order (once if they coincide), so two transfers can never wait on each
+// other in a cycle. Each stripe fills its own cache line.
+class AccountLocks {
+public:
+    static const int STRIPES = 1024;
+    struct alignas(64) Stripe {
+        std::mutex lock;
+    };
+    Stripe stripes[STRIPES];
+
+    static int stripeOf(int userIndex) {
+        return userIndex % STRIPES;
+    }
+
+    void lockPair(int a, int b) {
+        int first = stripeOf(a);
+        int second = stripeOf(b);
+        if (first > second) std::swap(first, second);
+        stripes[first].lock.lock();
+        if (second != first) stripes[second].lock.lock();
+    }
+
+    void unlockPair(int a, int b) {
+        int first = stripeOf(a);
+        int second = stripeOf(b);
+        if (second != first) stripes[second].lock.unlock();
+        stripes[first].lock.unlock();
+    }
+
+    // Every stripe, in the same order lockPair takes them, so no transfer
+    // is half applied while the holder saves or checkpoints.
+    void lockAll() {
+        for (int i = 0; i < STRIPES; i++) {
+            stripes[i].lock.lock();
+        }
+    }
+
+    void unlockAll() {
+        for (int i = STRIPES - 1; i >= 0; i--) {
+            stripes[i].lock.unlock();
+        }
+    }
+};
+
+// One operation from a batch settlement file.
+struct BatchOperation {
+    char kind;  // 'D'eposit, 'W'ithdraw or 'T'ransfer
+    std::string fromAccount;
+    std::string toAccount;
+    Money amount;
+};
+
+// What a batch run did, for the caller to report: operations per outcome,
+// the first few rejected ones (e.g. "line 12: unknown account") and how
+// long applying and committing took.
+struct BatchSummary {
+    static const int MAX_PROBLEMS = 10;
+    bool opened;
+    long long operations;
+    long long malformed;
+    long long outcomes[OP_STATUS_COUNT];
+    std::string problems[MAX_PROBLEMS];
+    int problemCount;
+    double applySeconds;
+    double totalSeconds;
+
+    BatchSummary() : opened(false), operations(0), malformed(0), problemCount(0), applySeconds(0), totalSeconds(0) {
+        for (int i = 0; i < OP_STATUS_COUNT; i++) {
+            outcomes[i] = 0;
+        }
+    }
+};
+
+
+class BankingSystem {
+public:
+    static const int MAX_LOADED_USERS = 10000000;
+    static const long long JOURNAL_CHECKPOINT_BYTES = 4 * 1024 * 1024;
+    static const int HISTORY_PAGE_SIZE = 20;
+    static const int SCHEDULER_BATCH_SIZE = 1 << 20;
+    static const int LISTED_SCHEDULED_PAYMENTS = 10;
+    static const int PAYMENT_IDS_PER_RECORD = 256;
+    static const int MAX_JOURNAL_FIELDS = PAYMENT_IDS_PER_RECORD + 1;
+    static const int SEGMENT_USERS = 4096;
+    User** users;
+    int capacity;
+    int userCount;
+    int nextUserID;
+    int invalidIDAttempts;
+    PaymentPriorityQueue scheduledPayments;
+    std::string dataFileName;
+    std::string snapshotFileName;
+    bool persistent;
+    UserIndex accountIndex;
+    UserIndex userIDIndex;
+    UserIndex emailIndex;
+    AccountLocks accountLocks;
+    // File backing each segment of SEGMENT_USERS accounts in the current
+    // manifest; empty when the segment has never been written.
+    std::string* segmentFiles;
+    int segmentCapacity;
+    // Background checkpoint in flight (checkpointWriter joinable): the
+    // thread writing it, whether it has finished and succeeded, the new
+    // file of each segment it rewrites and the serialised files it writes
+    // (the segments, then the manifest).
+    std::thread checkpointWriter;
+    std::atomic<bool> checkpointDone;
+    bool checkpointOk;
+    std::string* checkpointSegments;
+    int checkpointSegmentCount;
+    SnapshotWriter* checkpointOutput;
+    std::string journalFileName;
+    Journal journal;
+    // Serialises commit() past the journal, which is safe to share: the
+    // snapshot fallback and the checkpoint it starts or adopts are not.
+    std::mutex commitLock;
+    // Guards all of the above once the scheduler thread is running; the
+    // scheduler sleeps on paymentsChanged until the earliest payment is due
+    // or a new payment is queued.
+    std::mutex stateLock;
+    std::condition_variable paymentsChanged;
+    std::thread scheduler;
+    bool schedulerStopping;
+    long long scheduledRun;
+    long long scheduledBatches;
+    // Payments that actually moved money; lateness is averaged over these.
+    long long scheduledSettled;
+    long long totalLatenessMs;
+    long long maxLatenessMs;
+
+    // A non-persistent system starts empty and never touches the data files;
+    // the snapshot converter uses it as a scratch store.
+    explicit BankingSystem(bool persist = true);
+   
+    ~BankingSystem();
+
+    void clearUsers();
+
+    bool isValidName(const std::string& name);
+
+    bool isValidEmail(const std::string& email);
+
+    bool isValidPassword(const std::string& password) {
+        if (password.empty() || password.length() < 4 || password.length() > 20) return false;
+        return true;
+    }
+
+    bool isValidPIN(const std::string& pin);
+
+    bool isValidPhone(const std::string& phone);
+
+    bool isValidAmount(Money amount) {
+        if (amount.cents < 0 || amount.cents > 100000000LL) return false;
+        return true;
+    }
+
+    bool isEmailUnique(const std::string& email) {
+        return emailIndex.find(email, users) == -1;
+    }
+
+    bool isUserIDUnique(const std::string& userID) {
+        return userIDIndex.find(userID, users) == -1;
+    }
+
+    std::string formatBalance(Money amount) {
+        return amount.format();
+    }
+
+    void resizeArray();
+   
+    int findUserByAccountNumber(const std::string &accountNumber) {
+        return accountIndex.find(accountNumber, users);
+    }
+
+    int findUserByUserID(const std::string &userID) {
+        return userIDIndex.find(userID, users);
+    }
+
+    void indexUser(int index) {
+        accountIndex.insert(index, users);
+        userIDIndex.insert(index, users);
+        emailIndex.insert(index, users);
+    }
+
+    void rebuildIndexes();
+
+    std::string generateUserID();
+
+    // Settles the payments due now, up to limit, as one batch: they are
+    // taken off the queue together, every account is resolved before any
+    // money moves, and their removal is journalled in a few multi-ID
+    // records. Payments are checked in due order against running balances
+    // grouped by account; each account then gets its history rows in one
+    // append and a single balance change, and the whole batch is committed
+    // once. Lateness against the due time is added to the scheduler
+    // statistics for the payments that settled. Returns the number of
+    // payments taken off the queue.
+    int processScheduledPayments(int limit = SCHEDULER_BATCH_SIZE);
+
+    // Starts the thread that runs scheduled payments as they fall due.
+    // Callers must hold stateLock around every other use of the system
+    // from then on.
+    void startScheduler() {
+        if (scheduler.joinable()) return;
+        schedulerStopping = false;
+        scheduler = std::thread(&BankingSystem::runScheduler, this);
+    }
+
+    void stopScheduler();
+
+    // Sleeps until the head of the payment queue is due, then runs due
+    // payments a batch at a time, releasing the lock between batches so
+    // the console and server are never held off for long.
+    void runScheduler();
+
+    // Money movements without any prompting: validate, then record both
+    // the transaction and its security log entry. Callers commit.
+    OperationStatus applyDeposit(User* user, Money amount);
+
+    OperationStatus applyWithdrawal(User* user, Money amount);
+
+    OperationStatus applyTransfer(User* from, User* to, Money amount);
+
+    // Takes back user's last n undoable operations, newest first, all or
+    // nothing: each must be inside UNDO_WINDOW and not a scheduled payment,
+    // and no account may be left below zero. A transfer is reversed on
+    // both accounts, which needs the other side's entry still in its ring.
+    // Callers commit.
+    OperationStatus undoLast(User* user, int n = 1);
+
+    // Transfer between two loaded accounts that may run on several threads
+    // at once. Only the two accounts' lock stripes are held, so transfers
+    // between unrelated accounts proceed in parallel. Accounts must not be
+    // added or removed while transfers run; callers commit.
+    OperationStatus transferConcurrent(int fromIndex, int toIndex, Money amount);
+
+    Money totalBalance() const;
+
+    // Queues a payment from user to toAccount at executeAt; paymentID
+    // receives the new payment's ID. With a repeat unit the payment recurs
+    // every `every` units until maxRuns payments (0 = no limit) have been
+    // made or endAt (0 = none) has passed.
+    OperationStatus applySchedule(User* user, const std::string& toAccount, Money amount, long executeAt, std::string& paymentID,
+                                  char unit = PaymentPriorityQueue::RECUR_NONE, int every = 0, int maxRuns = 0, long long endAt = 0);
+
+    // Cancels one of user's own scheduled payments.
+    OperationStatus applyCancel(User* user, const std::string& paymentID);
+
+    // Password check for callers without a console: same lockout rules
+    // and security log as the login screen, minus the prompts.
+    OperationStatus authenticate(const std::string& userID, const std::string& password, User*& user);
+
+    OperationStatus checkPIN(User* user, const std::string& pin);
+
+    // Opens an account with the given details after the same checks the
+    // sign-up screen makes; user receives the new account. Callers commit.
+    OperationStatus openAccount(const std::string& name, const std::string& email, const std::string& phone, const std::string& address,
+                                const std::string& accountType, Money initialBalance, const std::string& password, const std::string& pin,
+                                User*& user);
+
+    // Changes user's email, keeping the email index in step.
+    OperationStatus changeEmail(User* user, const std::string& email);
+
+    // Counts a login with an unknown user ID; returns the count so far.
+    // The count survives restarts and is cleared by the next good login.
+    int recordInvalidUserID() {
+        invalidIDAttempts++;
+        logSystemCounters();
+        return invalidIDAttempts;
+    }
+
+    void clearInvalidUserIDs() {
+        if (invalidIDAttempts == 0) return;
+        invalidIDAttempts = 0;
+        logSystemCounters();
+    }
+
+    OperationStatus applyBatchOperation(const BatchOperation& op);
+
+    // Parses one CSV line of a batch file:
+    //   DEPOSIT,<account>,<amount>
+    //   WITHDRAW,<account>,<amount>
+    //   TRANSFER,<from account>,<to account>,<amount>
+    // D, W and T work as short forms; spaces around fields are ignored.
+    static bool parseBatchLine(const std::string& line, BatchOperation& op);
+
+    // Applies a settlement file with the same checks as the console screens
+    // and commits once at the end with a single checkpoint; operations that
+    // fail a check are counted and skipped. The file is CSV (see
+    // parseBatchLine) or the binary form written by --compile-batch:
+    // "SWBATCH1", then per operation a u8 kind, from and to account strings
+    // and i64 cents, encoded as in snapshots. Returns whether the batch was
+    // committed; summary says what happened to each operation. If the
+    // checkpoint fails the applied operations are only in memory, so the
+    // journal is marked unsaved and the exit checkpoint tries again.
+    bool runBatch(const std::string& fileName, BatchSummary& summary);
+
+    // Keeps the first few rejected operations of a batch; the outcome
+    // counts cover the rest.
+    void reportBatchProblem(BatchSummary& summary, const char* unit, long long where, const char* reason) {
+        if (summary.problemCount >= BatchSummary::MAX_PROBLEMS) return;
+        summary.problems[summary.problemCount++] = std::string(unit) + " " + std::to_string(where) + ": " + reason;
+    }
+
+    // Checkpoint: rewrites the segments holding changed accounts, then the
+    // manifest naming every segment, and starts a fresh journal. Segment
+    // files replaced by this checkpoint are removed once the manifest is
+    // in place. Runs in the caller's thread, after any background
+    // checkpoint has finished.
+    bool saveToFile();
+
+    // Starts a checkpoint written by a thread of its own. The changed
+    // segments and the manifest are serialised here, while the caller
+    // still holds every account, so the thread only writes, syncs and
+    // renames files and the system goes on taking requests meanwhile.
+    // Changes made meanwhile go to a fresh journal; the one the snapshot
+    // covers is kept as bank_data.journal.old until the new manifest is in
+    // place, and startup replays both if it never was.
+    void startBackgroundCheckpoint();
+
+    // Checkpoint thread: writes checkpointOutput and sets checkpointOk,
+    // then checkpointDone.
+    void runCheckpointWriter();
+
+    // Collects a background checkpoint once its thread is done (waiting
+    // for it when wait is set). On success the new segment files replace
+    // the old ones; on failure their accounts are marked dirty again and
+    // the checkpoint is redone in this thread.
+    void finishBackgroundCheckpoint(bool wait);
+
+    std::string previousJournalFileName() const {
+        return journalFileName + ".old";
+    }
+
+    int segmentCountFor(int users) const {
+        return (users + SEGMENT_USERS - 1) / SEGMENT_USERS;
+    }
+
+    // Segment file names are relative to the manifest's directory.
+    std::string segmentFileName(int segment, long long generation) const {
+        std::string base = snapshotFileName.substr(snapshotFileName.find_last_of('/') + 1);
+        return base + ".seg" + std::to_string(segment) + "." + std::to_string(generation);
+    }
+
+    std::string snapshotDirectory(const std::string& fileName) const {
+        size_t slash = fileName.find_last_of('/');
+        return slash == std::string::npos ? "" : fileName.substr(0, slash + 1);
+    }
+
+    void setSegmentDirty(int segment, bool dirty);
+
+    // Picks the segments a checkpoint must rewrite: written[s] gets the new
+    // file name for segment s, or stays empty when its current file is
+    // still accurate. Returns the number of segments.
+    int planCheckpoint(long long generation, std::string*& written);
+
+    void serializeSegment(int segment, long long generation, SnapshotWriter& out);
+
+    void serializeManifest(long long generation, const std::string* written, int segments, SnapshotWriter& out);
+
+    // Writes the planned segment files and then the manifest, each through
+    // a synced temporary file, and finally syncs the directory.
+    bool writeCheckpointFiles(long long generation, const std::string* written, int segments);
+
+    // The same for files already serialised into output, one per segment
+    // and the manifest last; touches no account, so any thread may run it.
+    bool writeCheckpointOutput(const std::string* written, int segments, const SnapshotWriter* output) const;
+
+    // Makes the written segment files current. clearDirty is set only by
+    // saveToFile: a background checkpoint cleared the flags when it started,
+    // and clearing them again would lose changes made while it ran.
+    void adoptCheckpointFiles(const std::string* written, int segments, bool clearDirty);
+
+    void discardCheckpointFiles(const std::string* written, int segments);
+
+    // A single self-contained snapshot with every user inline; written by
+    // the converter.
+    bool saveBinaryFile(const std::string& fileName, long long generation);
+
+    void putPayments(SnapshotWriter& out);
+
+    // Writes through fileName.tmp, synced and then renamed over fileName,
+    // so a crash leaves either the old contents or the new ones.
+    static bool writeSnapshotFile(const std::string& fileName, const SnapshotWriter& out);
+
+    // Makes renames in directory ("" for the working directory) durable.
+    static bool syncDirectory(const std::string& directory);
+
+    // Legacy line-per-field format, still read when no binary snapshot
+    // exists and written by the converter.
+    bool saveTextFile(const std::string& fileName, long long generation);
+
+    // Makes the changes recorded since the last commit durable, as the
+    // durability mode asks: one journal append in the common case. Once the
+    // journal is large a background checkpoint folds it into the snapshot;
+    // if it cannot be written the snapshot is saved in place of it. Safe
+    // to call from several threads alongside transferConcurrent.
+    void commit();
+
+    void logSystemCounters() {
+        std::string fields[] = {"S", std::to_string(nextUserID), std::to_string(invalidIDAttempts)};
+        journal.append(fields, 3);
+    }
+
+    void logNewUser(User* user) {
+        std::string fields[] = {"U", user->name, user->userID, user->password, user->pin, user->accountNumber, user->email,
+                           user->phone, user->address, user->accountType, user->balance.format(), user->dateCreated};
+        journal.append(fields, 12);
+    }
+
+    // One-off payments keep the original six-field record; recurring ones
+    // append their rule.
+    void logPaymentAdded(PaymentPriorityQueue::PQNode* payment);
+
+    void logPaymentsRemoved(PaymentPriorityQueue::PQNode** payments, int n);
+
+    void logPaymentRemoved(const std::string& paymentID) {
+        std::string fields[] = {"Q-", paymentID};
+        journal.append(fields, 2);
+    }
+
+    // Re-applies one journal record on top of the loaded snapshot. Records
+    // that refer to unknown accounts are skipped.
+    void applyJournalRecord(std::string* f, int n);
+
+    // Replays the journal written since the snapshot that loadFromFile just
+    // read, stopping at the first torn or corrupt record, and reopens it for
+    // appending. If a background checkpoint was cut short, the snapshot is
+    // followed by the journal it was folding in and then by the current
+    // one; both are replayed and folded into a new checkpoint here.
+    void replayJournal();
+
+    // Applies the records of one journal file whose header names the given
+    // generation. validBytes receives the end of its last intact record.
+    bool replayJournalFile(const std::string& fileName, long long generation, long long& validBytes);
+
+    void loadFromFile();
+
+    // Removes what an interrupted checkpoint leaves behind: temporary files
+    // and segment files the loaded manifest does not name. Segment files
+    // are only judged when the manifest had the layout checkpoints write.
+    void removeStaleSnapshotFiles();
+
+    // Maps a whole binary snapshot and verifies both checksums before
+    // touching any state. Returns false (leaving the system empty) if the
+    // file is missing or damaged.
+    bool loadBinaryFile(const std::string& fileName) {
+        MappedFile file;
+        if (!file.open(fileName)) return false;
+        return loadBinaryImage(file.data, file.size, snapshotDirectory(fileName));
+    }
+
+    // Loads a snapshot image; the segment files a manifest names are read
+    // from directory. When the segments have the layout checkpoints write,
+    // they are remembered so the next checkpoint can keep the clean ones.
+    bool loadBinaryImage(const char* image, size_t size, const std::string& directory);
+
+    // Reads count users from one segment file into users[first...]; they
+    // start clean since the file holds exactly their current state.
+    bool loadSegmentFile(const std::string& fileName, int first, int count);
+
+    // Single pass over the mapped text file. Tolerates the same damage the
+    // stream loader did: an implausible user count rejects the file, and a
+    // file that ends early keeps the users and payments read so far.
+    void loadTextFile(const std::string& fileName);
+};
+
+#endif